@@ -0,0 +1,590 @@
+// Banco de pruebas de rendimiento de las operaciones de imagen.
+// QUÉ: Mide cada operación pública sobre imágenes sintéticas de varios tamaños
+// y canales, para una lista de números de hilos.
+// CÓMO: Por cada combinación hace unas ejecuciones de calentamiento y luego N
+// repeticiones cronometradas (cada una sobre una copia fresca de la imagen);
+// reporta mediana, p95, Mpíxeles/s y eficiencia paralela en CSV o JSON.
+// POR QUÉ: Permite detectar regresiones y dimensionar hardware sin tener que
+// cronometrar a mano desde el menú.
+//
+// Compilar: ver compile-run.sh (gcc -O2 -o bench.out bench.c functions/... -pthread -lm)
+// Ejecutar: ./bench.out [--sizes 256,1024,4096] [--channels 1,3] [--threads 1,2,4]
+//                       [--ops brightness,lut,blur,blur20,sharpen,kernel7,sobel,resize,lanczos,
+//                              rotate,rotate30,flip,transpose,png]
+//                       [--warmup 1] [--reps 5] [--format csv|json] [-o archivo]
+//           ./bench.out --verify [--sizes ...] [--channels ...]
+//           (compara la convolución entera con la calculada en real)
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "functions/imagen_info.h"
+#include "functions/brightness.h"
+#include "functions/border.h"
+#include "functions/convolution.h"
+#include "functions/flip.h"
+#include "functions/png_writer.h"
+#include "functions/point.h"
+#include "functions/resize.h"
+#include "functions/rotation.h"
+#include "functions/simd.h"
+#include "functions/thread_pool.h"
+
+#define MAX_LISTA 32
+
+// ---------- Operaciones medidas ----------
+
+// Cada operación recibe una copia de la imagen y el número de hilos
+typedef int (*FuncionBench)(ImagenInfo *info, int numHilos);
+
+static int benchBrillo(ImagenInfo *info, int numHilos)
+{
+    return ajustarBrilloConcurrente(info, 40, numHilos);
+}
+
+// Tres ajustes tonales compuestos en una tabla: una sola pasada
+static int benchLut(ImagenInfo *info, int numHilos)
+{
+    LutPuntual lut;
+    lutIdentidad(&lut);
+    lutContraste(&lut, 1.2f);
+    lutGamma(&lut, 2.2f);
+    lutInvertir(&lut);
+    return aplicarLutConcurrente(info, &lut, numHilos);
+}
+
+static int benchDesenfoque(ImagenInfo *info, int numHilos)
+{
+    return aplicarConvolucionConcurrente(info, 7, 2.0f, numHilos);
+}
+
+// Sigma grande: va por el filtro recursivo
+static int benchDesenfoqueGrande(ImagenInfo *info, int numHilos)
+{
+    return aplicarConvolucionConcurrente(info, 0, 20.0f, numHilos);
+}
+
+// Gaussiana 7x7 como kernel 2D: mide el motor entero (49 taps por salida)
+static int benchKernel7(ImagenInfo *info, int numHilos)
+{
+    float pesos[49];
+    float *g = generarKernelGaussiano1D(7, 2.0f);
+    if (!g)
+        return 0;
+    for (int i = 0; i < 49; i++)
+        pesos[i] = g[i / 7] * g[i % 7];
+    free(g);
+    return aplicarKernelConcurrente(info, pesos, 7, numHilos);
+}
+
+static int benchRealce(ImagenInfo *info, int numHilos)
+{
+    KernelUsuario k;
+    return kernelPorNombre("sharpen", 3, &k) && aplicarKernelConcurrente(info, k.pesos, k.tam, numHilos);
+}
+
+static int benchSobel(ImagenInfo *info, int numHilos)
+{
+    return detectarBordesSobel(info, numHilos);
+}
+
+static int benchResize(ImagenInfo *info, int numHilos)
+{
+    return resizeBilinealConcurrente(info, info->ancho * 3 / 4, info->alto * 3 / 4, numHilos);
+}
+
+static int benchLanczos(ImagenInfo *info, int numHilos)
+{
+    return resizeFiltradoConcurrente(info, info->ancho / 4, info->alto / 4, FILTRO_LANCZOS3, numHilos);
+}
+
+static int benchRotar(ImagenInfo *info, int numHilos)
+{
+    return rotarImagenConcurrente(info, 90.0f, numHilos);
+}
+
+static int benchRotarLibre(ImagenInfo *info, int numHilos)
+{
+    return rotarImagenConcurrente(info, 30.0f, numHilos);
+}
+
+static int benchVoltear(ImagenInfo *info, int numHilos)
+{
+    return voltearHorizontal(info, numHilos);
+}
+
+// Las imágenes del banco son cuadradas
+static int benchTransponer(ImagenInfo *info, int numHilos)
+{
+    return transponerEnSitio(info, numHilos);
+}
+
+// El PNG se codifica a memoria: solo se cuentan los bytes
+static void descartarBytes(void *ctx, const void *datos, size_t largo)
+{
+    (void)datos;
+    *(size_t *)ctx += largo;
+}
+
+static int benchPNG(ImagenInfo *info, int numHilos)
+{
+    (void)numHilos; // el escritor usa todos los hilos del pool
+    size_t bytes = 0;
+    EscritorPNG *png = pngAbrir(descartarBytes, &bytes, info->ancho, info->alto, info->canales);
+    if (!png)
+        return 0;
+    int ok = pngEscribirFilas(png, info->pixeles, info->alto);
+    return pngCerrar(png) && ok;
+}
+
+typedef struct
+{
+    const char *nombre;
+    FuncionBench funcion;
+} OperacionBench;
+
+static const OperacionBench operaciones[] = {
+    {"brightness", benchBrillo},
+    {"lut", benchLut},
+    {"blur", benchDesenfoque},
+    {"blur20", benchDesenfoqueGrande},
+    {"sharpen", benchRealce},
+    {"kernel7", benchKernel7},
+    {"sobel", benchSobel},
+    {"resize", benchResize},
+    {"lanczos", benchLanczos},
+    {"rotate", benchRotar},
+    {"rotate30", benchRotarLibre},
+    {"flip", benchVoltear},
+    {"transpose", benchTransponer},
+    {"png", benchPNG},
+};
+#define NUM_OPERACIONES ((int)(sizeof(operaciones) / sizeof(operaciones[0])))
+
+// ---------- Utilidades ----------
+
+static double ahoraMs(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+static int compararDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil por rango más cercano sobre tiempos ordenados
+static double percentil(const double *ordenados, int n, int p)
+{
+    int rango = (p * n + 99) / 100;
+    if (rango < 1)
+        rango = 1;
+    return ordenados[rango - 1];
+}
+
+// Imagen sintética determinista: degradados con algo de ruido, para que los
+// filtros y el compresor PNG trabajen con contenido parecido a una foto
+static int crearImagenSintetica(ImagenInfo *info, int lado, int canales)
+{
+    if (!crearImagen(info, lado, lado, canales))
+        return 0;
+    unsigned int semilla = 12345u;
+    for (int y = 0; y < lado; y++)
+    {
+        unsigned char *fila = info->pixeles[y];
+        for (int x = 0; x < lado; x++)
+        {
+            semilla = semilla * 1103515245u + 12345u;
+            int ruido = (int)((semilla >> 16) & 15) - 8;
+            for (int c = 0; c < canales; c++)
+            {
+                int v = ((x * (c + 1) + y * (3 - c)) * 255 / (2 * lado)) + ruido;
+                fila[x * canales + c] = (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v));
+            }
+        }
+    }
+    return 1;
+}
+
+static int copiarImagen(const ImagenInfo *src, ImagenInfo *dst)
+{
+    if (!crearImagen(dst, src->ancho, src->alto, src->canales))
+        return 0;
+    for (int y = 0; y < src->alto; y++)
+        memcpy(dst->pixeles[y], src->pixeles[y], (size_t)src->ancho * src->canales);
+    return 1;
+}
+
+// Lee una lista de enteros positivos separados por comas
+static int leerListaEnteros(const char *texto, int *lista)
+{
+    int n = 0;
+    const char *p = texto;
+    while (*p && n < MAX_LISTA)
+    {
+        char *fin;
+        long v = strtol(p, &fin, 10);
+        if (fin == p || v <= 0 || v > 1 << 20 || (*fin != ',' && *fin != '\0'))
+            return 0;
+        lista[n++] = (int)v;
+        p = *fin == ',' ? fin + 1 : fin;
+    }
+    return n;
+}
+
+static int leerListaOperaciones(const char *texto, int *seleccion)
+{
+    int n = 0;
+    char copia[256];
+    snprintf(copia, sizeof(copia), "%s", texto);
+    for (char *tok = strtok(copia, ","); tok; tok = strtok(NULL, ","))
+    {
+        int encontrada = -1;
+        for (int i = 0; i < NUM_OPERACIONES; i++)
+            if (strcmp(tok, operaciones[i].nombre) == 0)
+                encontrada = i;
+        if (encontrada < 0 || n >= MAX_LISTA)
+        {
+            fprintf(stderr, "Operación desconocida: %s\n", tok);
+            return 0;
+        }
+        seleccion[n++] = encontrada;
+    }
+    return n;
+}
+
+static void mostrarUso(const char *programa)
+{
+    fprintf(stderr,
+            "Uso: %s [opciones]\n"
+            "  --sizes L1,L2,...     lados de las imágenes cuadradas (defecto 256,1024,4096)\n"
+            "  --channels 1,3        canales (defecto 1,3)\n"
+            "  --threads N1,N2,...   hilos (defecto 1,2,4,... hasta las CPUs disponibles)\n"
+            "  --ops a,b,...         operaciones: brightness, lut, blur, blur20, sharpen, kernel7, sobel,\n"
+            "                          resize, lanczos, rotate, rotate30, flip, transpose, png\n"
+            "  --warmup N            ejecuciones de calentamiento (defecto 1)\n"
+            "  --reps N              repeticiones medidas (defecto 5)\n"
+            "  --format csv|json     formato de salida (defecto csv)\n"
+            "  -o archivo            escribir resultados en archivo (defecto stdout)\n"
+            "  --verify              en vez de medir, comprobar el error de la convolución entera\n",
+            programa);
+}
+
+// ---------- Verificación de la convolución entera ----------
+
+typedef struct
+{
+    const char *nombre;
+    int tam;
+    float pesos[49];
+} KernelPrueba;
+
+// Suma en double con bordes replicados y round(), como la convolución en
+// float anterior al motor entero
+static unsigned char convolucionReferencia(const ImagenInfo *info, const KernelPrueba *k, int x, int y, int c)
+{
+    const int centro = k->tam / 2;
+    double suma = 0.0;
+    for (int ky = 0; ky < k->tam; ky++)
+    {
+        int py = y + ky - centro;
+        py = py < 0 ? 0 : (py >= info->alto ? info->alto - 1 : py);
+        for (int kx = 0; kx < k->tam; kx++)
+        {
+            int px = x + kx - centro;
+            px = px < 0 ? 0 : (px >= info->ancho ? info->ancho - 1 : px);
+            suma += info->pixeles[py][px * info->canales + c] * (double)k->pesos[ky * k->tam + kx];
+        }
+    }
+    double r = round(suma);
+    return (unsigned char)(r < 0.0 ? 0.0 : (r > 255.0 ? 255.0 : r));
+}
+
+// Compara aplicarKernelConcurrente con la referencia para unos kernels de
+// prueba; falla si alguna diferencia supera floor(cotaError) + 1
+static int verificarKernels(FILE *salida, const int *lados, int numLados, const int *canales, int numCanales)
+{
+    KernelPrueba kernels[4] = {
+        {"caja3", 3, {0}},
+        {"enfoque3", 3, {0, -1, 0, -1, 5, -1, 0, -1, 0}},
+        {"gauss5", 5, {0}},
+        {"gauss7", 7, {0}},
+    };
+    for (int i = 0; i < 9; i++)
+        kernels[0].pesos[i] = 1.0f / 9.0f;
+    for (int k = 2; k < 4; k++)
+    {
+        float *g = generarKernelGaussiano1D(kernels[k].tam, k == 2 ? 1.0f : 2.0f);
+        if (!g)
+            return 0;
+        for (int i = 0; i < kernels[k].tam * kernels[k].tam; i++)
+            kernels[k].pesos[i] = g[i / kernels[k].tam] * g[i % kernels[k].tam];
+        free(g);
+    }
+
+    int ok = 1;
+    fprintf(salida, "kernel,ancho,alto,canales,desplazamiento,cota,max_dif,bytes_distintos\n");
+    for (int l = 0; l < numLados; l++)
+    {
+        for (int c = 0; c < numCanales; c++)
+        {
+            ImagenInfo fuente;
+            if (!crearImagenSintetica(&fuente, lados[l], canales[c]))
+                return 0;
+            for (int k = 0; k < 4; k++)
+            {
+                ImagenInfo copia = {0};
+                KernelEntero entero = {0};
+                if (!copiarImagen(&fuente, &copia) || !cuantizarKernel(kernels[k].pesos, kernels[k].tam, &entero) ||
+                    !aplicarKernelConcurrente(&copia, kernels[k].pesos, kernels[k].tam, 0))
+                {
+                    liberarKernelEntero(&entero);
+                    liberarImagen(&copia);
+                    liberarImagen(&fuente);
+                    return 0;
+                }
+
+                int maxDif = 0;
+                long long distintos = 0;
+                for (int y = 0; y < fuente.alto; y++)
+                {
+                    for (int x = 0; x < fuente.ancho; x++)
+                    {
+                        for (int ch = 0; ch < fuente.canales; ch++)
+                        {
+                            int d = abs(copia.pixeles[y][x * fuente.canales + ch] -
+                                        convolucionReferencia(&fuente, &kernels[k], x, y, ch));
+                            maxDif = d > maxDif ? d : maxDif;
+                            distintos += d != 0;
+                        }
+                    }
+                }
+                if (maxDif > (int)floor(entero.cotaError) + 1)
+                    ok = 0;
+                fprintf(salida, "%s,%d,%d,%d,%d,%.4f,%d,%lld\n", kernels[k].nombre, lados[l], lados[l],
+                        canales[c], entero.desplazamiento, entero.cotaError, maxDif, distintos);
+                liberarKernelEntero(&entero);
+                liberarImagen(&copia);
+            }
+            liberarImagen(&fuente);
+        }
+    }
+    return ok;
+}
+
+// ---------- Programa principal ----------
+
+typedef struct
+{
+    const char *operacion;
+    int lado;
+    int canales;
+    int hilos;
+    double mediana;
+    double p95;
+    double mpixS;
+    double eficiencia;
+} ResultadoBench;
+
+static void escribirResultado(FILE *salida, int json, const ResultadoBench *r, int primero)
+{
+    if (json)
+    {
+        fprintf(salida,
+                "%s\n    {\"operacion\": \"%s\", \"ancho\": %d, \"alto\": %d, \"canales\": %d, "
+                "\"hilos\": %d, \"mediana_ms\": %.3f, \"p95_ms\": %.3f, \"mpix_s\": %.2f, "
+                "\"eficiencia\": %.3f}",
+                primero ? "" : ",", r->operacion, r->lado, r->lado, r->canales, r->hilos,
+                r->mediana, r->p95, r->mpixS, r->eficiencia);
+    }
+    else
+    {
+        fprintf(salida, "%s,%d,%d,%d,%d,%.3f,%.3f,%.2f,%.3f\n", r->operacion, r->lado, r->lado,
+                r->canales, r->hilos, r->mediana, r->p95, r->mpixS, r->eficiencia);
+    }
+    fflush(salida);
+}
+
+int main(int argc, char *argv[])
+{
+    int lados[MAX_LISTA] = {256, 1024, 4096}, numLados = 3;
+    int canales[MAX_LISTA] = {1, 3}, numCanales = 2;
+    int hilos[MAX_LISTA], numHilos = 0;
+    int seleccion[MAX_LISTA], numSeleccion = 0;
+    int calentamiento = 1, repeticiones = 5, json = 0, verificar = 0;
+    const char *rutaSalida = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *valor = i + 1 < argc ? argv[i + 1] : NULL;
+        int ok = 1;
+        if (strcmp(argv[i], "--verify") == 0)
+        {
+            verificar = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--sizes") == 0 && valor)
+            ok = (numLados = leerListaEnteros(valor, lados)) > 0;
+        else if (strcmp(argv[i], "--channels") == 0 && valor)
+        {
+            ok = (numCanales = leerListaEnteros(valor, canales)) > 0;
+            for (int c = 0; ok && c < numCanales; c++)
+                ok = canales[c] == 1 || canales[c] == 3;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && valor)
+            ok = (numHilos = leerListaEnteros(valor, hilos)) > 0;
+        else if (strcmp(argv[i], "--ops") == 0 && valor)
+            ok = (numSeleccion = leerListaOperaciones(valor, seleccion)) > 0;
+        else if (strcmp(argv[i], "--warmup") == 0 && valor)
+            ok = (calentamiento = atoi(valor)) >= 0;
+        else if (strcmp(argv[i], "--reps") == 0 && valor)
+            ok = (repeticiones = atoi(valor)) > 0;
+        else if (strcmp(argv[i], "--format") == 0 && valor)
+        {
+            json = strcmp(valor, "json") == 0;
+            ok = json || strcmp(valor, "csv") == 0;
+        }
+        else if (strcmp(argv[i], "-o") == 0 && valor)
+            rutaSalida = valor;
+        else
+        {
+            mostrarUso(argv[0]);
+            return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "Valor inválido para %s: %s\n", argv[i], valor);
+            return 1;
+        }
+        i++;
+    }
+
+    // Por defecto: potencias de dos hasta las CPUs disponibles (y estas)
+    if (numHilos == 0)
+    {
+        int maximo = poolHilosPorDefecto();
+        for (int n = 1; n < maximo && numHilos < MAX_LISTA - 1; n *= 2)
+            hilos[numHilos++] = n;
+        hilos[numHilos++] = maximo;
+    }
+    if (numSeleccion == 0)
+    {
+        for (int i = 0; i < NUM_OPERACIONES; i++)
+            seleccion[numSeleccion++] = i;
+    }
+
+    FILE *salida = rutaSalida ? fopen(rutaSalida, "w") : stdout;
+    if (!salida)
+    {
+        fprintf(stderr, "No se pudo abrir %s\n", rutaSalida);
+        return 1;
+    }
+
+    imagenModoSilencioso = 1;
+    fprintf(stderr, "SIMD: %s, CPUs disponibles: %d\n", nucleosSimd()->nombre, poolHilosPorDefecto());
+    if (verificar)
+    {
+        int ok = verificarKernels(salida, lados, numLados, canales, numCanales);
+        if (salida != stdout)
+            fclose(salida);
+        poolDestruir();
+        if (!ok)
+            fprintf(stderr, "La convolución entera supera la cota de error\n");
+        return ok ? 0 : 1;
+    }
+    if (json)
+        fprintf(salida, "{\n  \"simd\": \"%s\",\n  \"cpus\": %d,\n  \"resultados\": [",
+                nucleosSimd()->nombre, poolHilosPorDefecto());
+    else
+        fprintf(salida, "operacion,ancho,alto,canales,hilos,mediana_ms,p95_ms,mpix_s,eficiencia\n");
+
+    double *tiempos = (double *)malloc((size_t)repeticiones * sizeof(double));
+    if (!tiempos)
+    {
+        fprintf(stderr, "Error de memoria\n");
+        return 1;
+    }
+
+    int primero = 1, fallos = 0;
+    for (int l = 0; l < numLados; l++)
+    {
+        for (int c = 0; c < numCanales; c++)
+        {
+            ImagenInfo fuente;
+            if (!crearImagenSintetica(&fuente, lados[l], canales[c]))
+            {
+                fallos++;
+                continue;
+            }
+            const double megapixeles = (double)lados[l] * lados[l] / 1e6;
+
+            for (int o = 0; o < numSeleccion; o++)
+            {
+                const OperacionBench *op = &operaciones[seleccion[o]];
+                // Base de la eficiencia: la primera cantidad de hilos medida
+                double baseHilosPorTiempo = 0.0;
+
+                for (int h = 0; h < numHilos; h++)
+                {
+                    // El pool se rehace con exactamente los hilos medidos
+                    poolDestruir();
+                    poolIniciar(hilos[h]);
+
+                    int ok = 1;
+                    for (int r = 0; ok && r < calentamiento + repeticiones; r++)
+                    {
+                        ImagenInfo copia;
+                        if (!copiarImagen(&fuente, &copia))
+                        {
+                            ok = 0;
+                            break;
+                        }
+                        double t0 = ahoraMs();
+                        ok = op->funcion(&copia, hilos[h]);
+                        double t = ahoraMs() - t0;
+                        liberarImagen(&copia);
+                        if (r >= calentamiento)
+                            tiempos[r - calentamiento] = t;
+                    }
+                    if (!ok)
+                    {
+                        fprintf(stderr, "Falló %s %dx%d (%d canales, %d hilos)\n", op->nombre,
+                                lados[l], lados[l], canales[c], hilos[h]);
+                        fallos++;
+                        continue;
+                    }
+
+                    qsort(tiempos, repeticiones, sizeof(double), compararDoubles);
+                    ResultadoBench res;
+                    res.operacion = op->nombre;
+                    res.lado = lados[l];
+                    res.canales = canales[c];
+                    res.hilos = hilos[h];
+                    res.mediana = percentil(tiempos, repeticiones, 50);
+                    res.p95 = percentil(tiempos, repeticiones, 95);
+                    res.mpixS = megapixeles / (res.mediana / 1e3);
+                    if (baseHilosPorTiempo == 0.0)
+                        baseHilosPorTiempo = res.mediana * hilos[h];
+                    res.eficiencia = baseHilosPorTiempo / (res.mediana * hilos[h]);
+                    escribirResultado(salida, json, &res, primero);
+                    primero = 0;
+                }
+            }
+            liberarImagen(&fuente);
+        }
+    }
+
+    if (json)
+        fprintf(salida, "\n  ]\n}\n");
+    if (salida != stdout)
+        fclose(salida);
+    free(tiempos);
+    poolDestruir();
+    return fallos ? 1 : 0;
+}
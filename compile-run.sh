@@ -1 +1,2 @@
-gcc -o img.out img_base.c functions/rotation.c functions/resize.c functions/border.c functions/convolution.c  -pthread -lm
\ No newline at end of file
+gcc -o img.out img_base.c functions/imagen_info.c functions/brightness.c functions/rotation.c functions/flip.c functions/point.c functions/resize.c functions/border.c functions/convolution.c functions/thread_pool.c functions/png_writer.c functions/simd.c functions/stream.c functions/grafo.c  -pthread -lm
+gcc -O2 -o bench.out bench.c functions/imagen_info.c functions/brightness.c functions/rotation.c functions/flip.c functions/point.c functions/resize.c functions/border.c functions/convolution.c functions/thread_pool.c functions/png_writer.c functions/simd.c functions/stream.c functions/grafo.c  -pthread -lm
@@ -1,170 +1,125 @@
 #include "border.h"
-#include <pthread.h>
+#include "simd.h"
+#include "thread_pool.h"
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-static int crearimagenagenVaciaLocal(ImagenInfo *out, int ancho, int alto, int canales)
+// ---------- El Sobel ese ----------
+
+typedef struct
 {
-    out->ancho = ancho;
-    out->alto = alto;
-    out->canales = canales;
-    out->pixeles = (unsigned char ***)malloc(alto * sizeof(unsigned char **));
-    if (!out->pixeles)
-        return 0;
+    unsigned char **src; // [alto][ancho * canales], 1 o 3 canales
+    unsigned char **dst; // [alto][ancho], 1 canal
+    int ancho, alto, canales;
+    int fila_ini, fila_fin; // [ini, fin)
+    int error;              // algún hilo se quedó sin memoria
+} AgrumentosSobel;
 
-    for (int y = 0; y < alto; y++)
-    {
-        out->pixeles[y] = (unsigned char **)malloc(ancho * sizeof(unsigned char *));
-        if (!out->pixeles[y])
-        {
-            // liberar parcial
-            for (int yy = 0; yy < y; yy++)
-            {
-                for (int xx = 0; xx < ancho; xx++)
-                    free(out->pixeles[yy][xx]);
-                free(out->pixeles[yy]);
-            }
-            free(out->pixeles);
-            out->pixeles = NULL;
-            out->ancho = out->alto = out->canales = 0;
-            return 0;
-        }
-        for (int x = 0; x < ancho; x++)
-        {
-            out->pixeles[y][x] = (unsigned char *)malloc(canales * sizeof(unsigned char));
-            if (!out->pixeles[y][x])
-            {
-                // liberar parcial de esta fila
-                for (int xx = 0; xx < x; xx++)
-                    free(out->pixeles[y][xx]);
-                free(out->pixeles[y]);
-                // liberar filas anteriores
-                for (int yy = 0; yy < y; yy++)
-                {
-                    for (int xx2 = 0; xx2 < ancho; xx2++)
-                        free(out->pixeles[yy][xx2]);
-                    free(out->pixeles[yy]);
-                }
-                free(out->pixeles);
-                out->pixeles = NULL;
-                out->ancho = out->alto = out->canales = 0;
-                return 0;
-            }
-            for (int c = 0; c < canales; c++)
-                out->pixeles[y][x][c] = 0;
-        }
-    }
-    return 1;
-}
+// Con este clampi es que manejamos los bordes (Los que no alcanzan a tener la matriz 3x3 completa)
+static inline int clampi(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
 
-// Convierte a escala de grises porque se necesita para el metodo del Sobel ese
-static int escalaDeGrises(const ImagenInfo *src, ImagenInfo *dst)
+// Convierte una fila RGB a grises porque se necesita para el metodo del Sobel ese
+static void filaEnGrises(const unsigned char *src, unsigned char *gris, int ancho)
 {
-    if (!crearimagenagenVaciaLocal(dst, src->ancho, src->alto, 1))
-        return 0;
-
-    if (src->canales == 1)
+    for (int x = 0; x < ancho; x++)
     {
-        for (int y = 0; y < src->alto; y++)
-            for (int x = 0; x < src->ancho; x++)
-                dst->pixeles[y][x][0] = src->pixeles[y][x][0];
-        return 1;
-    }
-    else
-    {
-        for (int y = 0; y < src->alto; y++)
-        {
-            for (int x = 0; x < src->ancho; x++)
-            {
-                int r = src->pixeles[y][x][0];
-                int g = src->pixeles[y][x][1];
-                int b = src->pixeles[y][x][2];
-                int gray = (r + g + b) / 3; // simple y didáctico
-                if (gray < 0)
-                    gray = 0;
-                else if (gray > 255)
-                    gray = 255;
-                dst->pixeles[y][x][0] = (unsigned char)gray;
-            }
-        }
-        return 1;
+        const unsigned char *p = src + x * 3;
+        gris[x] = (unsigned char)((p[0] + p[1] + p[2]) / 3); // simple y didáctico
     }
 }
 
-// ---------- El Sobel ese ----------
-
-typedef struct
+// Fila y del gris (con clamp en Y). Con 1 canal es la fila original; con RGB
+// se convierte en el buffer de la ventana.
+static const unsigned char *filaGris(const AgrumentosSobel *S, int y, unsigned char *buffer)
 {
-    unsigned char ***src; // [alto][ancho][1]
-    unsigned char ***dst; // [alto][ancho][1]
-    int ancho, alto;
-    int fila_ini, fila_fin; // [ini, fin)
-} AgrumentosSobel;
-
-// Con este clampi y sample es que manejamos los bordes (Los que no alcanzan a tener la matriz 3x3 completa)
-static inline int clampi(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
+    y = clampi(y, 0, S->alto - 1);
+    if (S->canales == 1)
+        return S->src[y];
+    filaEnGrises(S->src[y], buffer, S->ancho);
+    return buffer;
+}
 
-static inline unsigned char sample(unsigned char ***A, int y, int x, int alto, int ancho)
+// Magnitud en la columna x replicando los píxeles de borde en X
+static unsigned char sobelPixelBorde(const unsigned char *a, const unsigned char *c,
+                                     const unsigned char *b, int x, int ancho)
 {
-    y = clampi(y, 0, alto - 1);
-    x = clampi(x, 0, ancho - 1);
-    return A[y][x][0];
+    int xi = clampi(x - 1, 0, ancho - 1);
+    int xd = clampi(x + 1, 0, ancho - 1);
+    int sx = (a[xd] - a[xi]) + 2 * (c[xd] - c[xi]) + (b[xd] - b[xi]);
+    int sy = (b[xi] + 2 * b[x] + b[xd]) - (a[xi] + 2 * a[x] + a[xd]);
+    int mag = (int)lround(sqrt((double)(sx * sx + sy * sy)));
+    return (unsigned char)(mag > 255 ? 255 : mag);
 }
 
+// Procesa las filas [fila_ini, fila_fin) con una ventana de 3 filas en
+// grises: cada fila del original se convierte una sola vez (más las dos de
+// halo de la tesela) y se descarta al salir de la ventana.
 static void *sobelWorker(void *arg)
 {
     AgrumentosSobel *S = (AgrumentosSobel *)arg;
-    static const int Gx[3][3] = {{-1, 0, 1},
-                                 {-2, 0, 2},
-                                 {-1, 0, 1}};
-    static const int Gy[3][3] = {{-1, -2, -1},
-                                 {0, 0, 0},
-                                 {1, 2, 1}};
+    const NucleosSimd *simd = nucleosSimd();
+
+    unsigned char *ventana = NULL;
+    if (S->canales != 1)
+    {
+        ventana = (unsigned char *)malloc((size_t)S->ancho * 3);
+        if (!ventana)
+        {
+            fprintf(stderr, "Sobel: error de memoria.\n");
+            S->error = 1;
+            return NULL;
+        }
+    }
+    unsigned char *buffers[3] = {ventana, NULL, NULL};
+    if (ventana)
+    {
+        buffers[1] = ventana + S->ancho;
+        buffers[2] = ventana + 2 * (size_t)S->ancho;
+    }
+    int ia = 0, ic = 1, ib = 2; // buffer de cada fila de la ventana
+
+    const unsigned char *arriba = filaGris(S, S->fila_ini - 1, buffers[ia]);
+    const unsigned char *centro = filaGris(S, S->fila_ini, buffers[ic]);
 
     for (int y = S->fila_ini; y < S->fila_fin; y++)
     {
+        // En la última fila el clamp en Y hace que abajo sea la central
+        const unsigned char *abajo = y + 1 < S->alto ? filaGris(S, y + 1, buffers[ib]) : centro;
+
+        // Columnas interiores con el núcleo SIMD; los bordes replican en X
+        if (S->ancho >= 3)
+            simd->sobelFila(arriba, centro, abajo, S->dst[y], S->ancho);
         for (int x = 0; x < S->ancho; x++)
         {
-            int sx = 0, sy = 0;
-            for (int ky = -1; ky <= 1; ky++)
-            {
-                for (int kx = -1; kx <= 1; kx++)
-                {
-                    int p = sample(S->src, y + ky, x + kx, S->alto, S->ancho);
-                    sx += Gx[ky + 1][kx + 1] * p;
-                    sy += Gy[ky + 1][kx + 1] * p;
-                }
-            }
-            int mag = (int)lround(sqrt((double)(sx * sx + sy * sy)));
-            if (mag > 255)
-                mag = 255;
-            if (mag < 0)
-                mag = 0;
-            S->dst[y][x][0] = (unsigned char)mag;
+            if (S->ancho >= 3 && x == 1)
+                x = S->ancho - 1;
+            S->dst[y][x] = sobelPixelBorde(arriba, centro, abajo, x, S->ancho);
         }
+
+        // Desplazar la ventana: el buffer de arriba se reutiliza para la
+        // siguiente fila de abajo
+        int libre = ia;
+        ia = ic;
+        ic = ib;
+        ib = libre;
+        arriba = centro;
+        centro = abajo;
     }
+
+    free(ventana);
     return NULL;
 }
 
-void liberarImagenBorder(ImagenInfo *info)
+// Adaptador para el pool: ejecuta sobelWorker sobre [fila_ini, fila_fin)
+static void sobelRango(void *ctx, int inicio, int fin)
 {
-    if (info->pixeles)
-    {
-        for (int y = 0; y < info->alto; y++)
-        {
-            for (int x = 0; x < info->ancho; x++)
-            {
-                free(info->pixeles[y][x]); // Liberar canales por píxel
-            }
-            free(info->pixeles[y]); // Liberar fila
-        }
-        free(info->pixeles); // Liberar arreglo de filas
-        info->pixeles = NULL;
-    }
-    info->ancho = 0;
-    info->alto = 0;
-    info->canales = 0;
+    AgrumentosSobel args = *(AgrumentosSobel *)ctx;
+    args.fila_ini = inicio;
+    args.fila_fin = fin;
+    sobelWorker(&args);
+    if (args.error)
+        ((AgrumentosSobel *)ctx)->error = 1;
 }
 
 int detectarBordesSobel(ImagenInfo *info, int nHilos)
@@ -174,79 +129,44 @@ int detectarBordesSobel(ImagenInfo *info, int nHilos)
         fprintf(stderr, "Sobel: imagen inválida.\n");
         return 0;
     }
-
-    if (nHilos <= 0)
-        nHilos = 2;
-    if (nHilos > info->alto)
-        nHilos = info->alto;
-
-    // 1) Convertir a grises (buffer temporal)
-    ImagenInfo gris = {0};
-    if (!escalaDeGrises(info, &gris))
+    // filaEnGrises lee RGB de 3 bytes por píxel
+    if (info->canales != 1 && info->canales != 3)
     {
-        fprintf(stderr, "Sobel: error convirtiendo a grises.\n");
+        fprintf(stderr, "Sobel: solo imágenes en grises o RGB (%d canales).\n", info->canales);
         return 0;
     }
 
-    // 2) Crear destino
+    nHilos = poolResolverHilos(nHilos);
+    if (nHilos > info->alto)
+        nHilos = info->alto;
+
+    // 1) Crear destino (mapa de bordes en gris)
     ImagenInfo dst = {0};
-    if (!crearimagenagenVaciaLocal(&dst, gris.ancho, gris.alto, 1))
+    if (!crearImagen(&dst, info->ancho, info->alto, 1))
     {
         fprintf(stderr, "Sobel: error creando salida.\n");
-        liberarImagenBorder(&gris);
         return 0;
     }
 
-    // 3) Hilos
-    pthread_t *hilos = (pthread_t *)malloc((size_t)nHilos * sizeof(pthread_t));
-    AgrumentosSobel *args = (AgrumentosSobel *)malloc((size_t)nHilos * sizeof(AgrumentosSobel));
-    if (!hilos || !args)
+    // 2) Repartir las filas en el pool: cada tesela convierte a grises sobre
+    // la marcha, sin imagen gris intermedia
+    AgrumentosSobel args;
+    args.src = info->pixeles;
+    args.dst = dst.pixeles;
+    args.ancho = info->ancho;
+    args.alto = info->alto;
+    args.canales = info->canales;
+    args.error = 0;
+    poolParaleloForTeselas(info->alto, nHilos, poolFilasPorTesela((size_t)info->ancho), sobelRango, &args);
+    if (args.error)
     {
-        fprintf(stderr, "Sobel: error de memoria para hilos.\n");
-        free(hilos);
-        free(args);
-        liberarImagenBorder(&gris);
-        liberarImagenBorder(&dst);
+        liberarImagen(&dst);
         return 0;
     }
 
-    int filasPorHilo = (gris.alto + nHilos - 1) / nHilos;
-    for (int i = 0; i < nHilos; i++)
-    {
-        args[i].src = gris.pixeles;
-        args[i].dst = dst.pixeles;
-        args[i].ancho = gris.ancho;
-        args[i].alto = gris.alto;
-        args[i].fila_ini = i * filasPorHilo;
-        args[i].fila_fin = (i + 1) * filasPorHilo;
-        if (args[i].fila_fin > gris.alto)
-            args[i].fila_fin = gris.alto;
-
-        if (pthread_create(&hilos[i], NULL, sobelWorker, &args[i]) != 0)
-        {
-            fprintf(stderr, "Sobel: error creando hilo %d.\n", i);
-            for (int j = 0; j < i; j++)
-                pthread_join(hilos[j], NULL);
-            free(hilos);
-            free(args);
-            liberarImagenBorder(&gris);
-            liberarImagenBorder(&dst);
-            return 0;
-        }
-    }
-    for (int i = 0; i < nHilos; i++)
-        pthread_join(hilos[i], NULL);
-    free(hilos);
-    free(args);
-
-    // 4) Reemplazar imagen original con el resultado
-    liberarImagenBorder(info);
-    *info = dst;       // mueve punteros
-    info->canales = 1; // mapa de bordes en gris
-
-    // 5) Liberar temporales
-    liberarImagenBorder(&gris);
+    // 3) Reemplazar imagen original con el resultado
+    reemplazarImagen(info, &dst); // mueve punteros; mapa de bordes en gris
 
-    printf("Bordes (Sobel) aplicados con %d hilos.\n", nHilos);
+    IMG_INFO("Bordes (Sobel) aplicados con %d hilos.\n", nHilos);
     return 1;
 }
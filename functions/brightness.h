@@ -0,0 +1,25 @@
+#ifndef BRIGHTNESS_H
+#define BRIGHTNESS_H
+
+#include "imagen_info.h"
+
+// QUÉ: Estructura para pasar datos al hilo de ajuste de brillo.
+// CÓMO: Contiene matriz, rango de filas, ancho, canales y delta de brillo.
+// POR QUÉ: Los hilos necesitan datos específicos para procesar en paralelo.
+typedef struct
+{
+    unsigned char **pixeles;
+    int inicio;
+    int fin;
+    int ancho;
+    int canales;
+    int delta;
+} BrilloArgs;
+
+// Función que ejecuta cada hilo sobre las filas [inicio, fin)
+void *ajustarBrilloHilo(void *args);
+
+// numHilos <= 0 usa el número de hilos por defecto del pool
+int ajustarBrilloConcurrente(ImagenInfo *info, int delta, int numHilos);
+
+#endif // BRIGHTNESS_H
@@ -1,126 +1,270 @@
 #include "convolution.h"
-#include <pthread.h>
+#include "simd.h"
+#include "thread_pool.h"
 #include <math.h>
 #include <string.h>
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-float **generarKernelGaussiano(int tamKernel, float sigma)
+float *generarKernelGaussiano1D(int tamKernel, float sigma)
 {
-    // Asignar memoria para el kernel
-    float **kernel = (float **)malloc(tamKernel * sizeof(float *));
+    float *kernel = (float *)malloc(tamKernel * sizeof(float));
     if (!kernel)
     {
         fprintf(stderr, "Error de memoria al asignar kernel\n");
         return NULL;
     }
 
-    for (int i = 0; i < tamKernel; i++)
-    {
-        kernel[i] = (float *)malloc(tamKernel * sizeof(float));
-        if (!kernel[i])
-        {
-            fprintf(stderr, "Error de memoria al asignar fila del kernel\n");
-            // Liberar memoria ya asignada
-            for (int j = 0; j < i; j++)
-            {
-                free(kernel[j]);
-            }
-            free(kernel);
-            return NULL;
-        }
-    }
-
-    // Calcular centro del kernel
+    // La Gaussiana 2D es el producto de dos 1D: G(x, y) = g(x) * g(y)
     int centro = tamKernel / 2;
     float suma = 0.0f;
-
-    // Generar valores del kernel usando fórmula Gaussiana
-    for (int y = 0; y < tamKernel; y++)
+    for (int x = 0; x < tamKernel; x++)
     {
-        for (int x = 0; x < tamKernel; x++)
-        {
-            int dx = x - centro;
-            int dy = y - centro;
-
-            // Fórmula de distribución Gaussiana 2D
-            float exponente = -(dx * dx + dy * dy) / (2.0f * sigma * sigma);
-            kernel[y][x] = exp(exponente) / (2.0f * M_PI * sigma * sigma);
-            suma += kernel[y][x];
-        }
+        int dx = x - centro;
+        kernel[x] = exp(-(dx * dx) / (2.0f * sigma * sigma));
+        suma += kernel[x];
     }
 
     // Normalizar el kernel para que la suma sea 1
-    for (int y = 0; y < tamKernel; y++)
+    for (int x = 0; x < tamKernel; x++)
     {
-        for (int x = 0; x < tamKernel; x++)
-        {
-            kernel[y][x] /= suma;
-        }
+        kernel[x] /= suma;
     }
 
     return kernel;
 }
 
-void liberarKernel(float **kernel, int tamKernel)
+// Mayor desplazamiento probado: con más bits ningún kernel razonable cabe
+#define DESPLAZAMIENTO_MAXIMO 30
+
+// Cuantiza con un desplazamiento dado; devuelve 0 si algún peso no cabe en
+// int16 o la suma de |peso| * 255 (más el redondeo) no cabe en int32
+static int cuantizarConDesplazamiento(const float *pesos, int n, int desplazamiento, int16_t *q)
 {
-    if (kernel)
+    const double escala = ldexp(1.0, desplazamiento);
+    double sumaReal = 0.0;
+    long long sumaEntera = 0;
+    int mayor = 0;
+    for (int i = 0; i < n; i++)
     {
-        for (int i = 0; i < tamKernel; i++)
+        double v = round(pesos[i] * escala);
+        if (fabs(v) > 32767.0)
+            return 0;
+        q[i] = (int16_t)v;
+        sumaReal += pesos[i];
+        sumaEntera += q[i];
+        if (abs(q[i]) > abs(q[mayor]))
+            mayor = i;
+    }
+
+    // El error de redondeo de la suma va al peso mayor, donde menos pesa
+    long long corregido = q[mayor] + (long long)llround(sumaReal * escala) - sumaEntera;
+    if (corregido < -32767 || corregido > 32767)
+        return 0;
+    q[mayor] = (int16_t)corregido;
+
+    long long cota = desplazamiento > 0 ? 1LL << (desplazamiento - 1) : 0;
+    for (int i = 0; i < n; i++)
+        cota += 255LL * abs(q[i]);
+    return cota <= INT32_MAX;
+}
+
+int cuantizarKernel(const float *pesos, int tam, KernelEntero *kernel)
+{
+    const int n = tam * tam;
+    const int numPares = (tam + 1) / 2;
+    int16_t *q = (int16_t *)malloc((size_t)n * sizeof(int16_t));
+    int32_t *pares = (int32_t *)malloc((size_t)tam * numPares * sizeof(int32_t));
+    if (!q || !pares)
+    {
+        fprintf(stderr, "Error de memoria al cuantizar el kernel\n");
+        free(q);
+        free(pares);
+        return 0;
+    }
+
+    int desplazamiento = DESPLAZAMIENTO_MAXIMO;
+    while (desplazamiento >= 0 && !cuantizarConDesplazamiento(pesos, n, desplazamiento, q))
+        desplazamiento--;
+    if (desplazamiento < 0)
+    {
+        fprintf(stderr, "Los pesos del kernel son demasiado grandes para la aritmética entera\n");
+        free(q);
+        free(pares);
+        return 0;
+    }
+
+    const double escala = ldexp(1.0, desplazamiento);
+    double error = 0.0;
+    for (int i = 0; i < n; i++)
+        error += fabs(q[i] / escala - pesos[i]);
+
+    for (int ky = 0; ky < tam; ky++)
+    {
+        for (int j = 0; j < numPares; j++)
         {
-            free(kernel[i]);
+            const int16_t *fila = q + (size_t)ky * tam;
+            uint32_t alto = 2 * j + 1 < tam ? (uint16_t)fila[2 * j + 1] : 0;
+            pares[ky * numPares + j] = (int32_t)((uint16_t)fila[2 * j] | alto << 16);
         }
-        free(kernel);
     }
+
+    kernel->tam = tam;
+    kernel->desplazamiento = desplazamiento;
+    kernel->pesos = q;
+    kernel->pares = pares;
+    kernel->cotaError = 255.0 * error;
+    return 1;
+}
+
+void liberarKernelEntero(KernelEntero *kernel)
+{
+    free(kernel->pesos);
+    free(kernel->pares);
+    kernel->pesos = NULL;
+    kernel->pares = NULL;
+}
+
+// Redondeo y clamp de una suma entera de convolucionHilo (igual que los núcleos)
+static inline unsigned char redondearEntero(int32_t suma, int desplazamiento)
+{
+    if (desplazamiento > 0)
+        suma += 1 << (desplazamiento - 1);
+    suma >>= desplazamiento;
+    return (unsigned char)(suma < 0 ? 0 : (suma > 255 ? 255 : suma));
 }
 
 void *convolucionHilo(void *args)
 {
     ConvolucionArgs *cArgs = (ConvolucionArgs *)args;
-    int centro = cArgs->tamKernel / 2;
+    const NucleosSimd *simd = nucleosSimd();
+    const KernelEntero *kernel = cArgs->kernel;
+    const int tam = kernel->tam;
+    const int centro = tam / 2;
+    const int canales = cArgs->canales;
+
+    // Filas de la vecindad con el clamp en Y ya resuelto (una vez por fila) y
+    // las mismas filas desplazadas al primer tap del interior
+    const unsigned char *filasLocales[2 * 64];
+    const unsigned char **filas = filasLocales;
+    if (tam > 64)
+    {
+        filas = (const unsigned char **)malloc(2 * (size_t)tam * sizeof(unsigned char *));
+        if (!filas)
+        {
+            fprintf(stderr, "Error de memoria en la convolución\n");
+            cArgs->error = 1;
+            return NULL;
+        }
+    }
+    const unsigned char **interior = filas + tam;
+
+    // Columnas interiores: todos los taps caen dentro de la fila
+    int interiorIni = centro < cArgs->ancho ? centro : cArgs->ancho;
+    int interiorFin = cArgs->ancho - centro > interiorIni ? cArgs->ancho - centro : interiorIni;
 
     for (int y = cArgs->inicio; y < cArgs->fin; y++)
     {
+        for (int ky = 0; ky < tam; ky++)
+        {
+            // Manejo de bordes: replicar filas de borde
+            int py = y + ky - centro;
+            if (py < 0)
+                py = 0;
+            if (py >= cArgs->alto)
+                py = cArgs->alto - 1;
+            filas[ky] = cArgs->pixeles[py];
+            interior[ky] = filas[ky] + (ptrdiff_t)(interiorIni - centro) * canales;
+        }
+        unsigned char *salida = cArgs->pixelesResultado[y];
+
+        simd->convolucionEnteraFila(interior, kernel->pares, tam, canales, kernel->desplazamiento,
+                                    salida + (size_t)interiorIni * canales,
+                                    (size_t)(interiorFin - interiorIni) * canales);
+
+        // Bordes en X: replicar píxeles de borde
         for (int x = 0; x < cArgs->ancho; x++)
         {
-            for (int c = 0; c < cArgs->canales; c++)
+            if (x == interiorIni)
+                x = interiorFin;
+            if (x >= cArgs->ancho)
+                break;
+            for (int c = 0; c < canales; c++)
             {
-                float suma = 0.0f;
-
-                // Aplicar kernel en la vecindad del píxel
-                for (int ky = 0; ky < cArgs->tamKernel; ky++)
+                int32_t suma = 0;
+                for (int ky = 0; ky < tam; ky++)
                 {
-                    for (int kx = 0; kx < cArgs->tamKernel; kx++)
+                    const int16_t *k = kernel->pesos + (size_t)ky * tam;
+                    for (int kx = 0; kx < tam; kx++)
                     {
-                        // Calcular coordenadas con manejo de bordes
                         int px = x + kx - centro;
-                        int py = y + ky - centro;
-
-                        // Manejo de bordes: replicar píxeles de borde
                         if (px < 0)
                             px = 0;
                         if (px >= cArgs->ancho)
                             px = cArgs->ancho - 1;
-                        if (py < 0)
-                            py = 0;
-                        if (py >= cArgs->alto)
-                            py = cArgs->alto - 1;
-
-                        // Multiplicar píxel por valor del kernel
-                        suma += cArgs->pixeles[py][px][c] * cArgs->kernel[ky][kx];
+                        suma += filas[ky][(size_t)px * canales + c] * k[kx];
                     }
                 }
+                salida[(size_t)x * canales + c] = redondearEntero(suma, kernel->desplazamiento);
+            }
+        }
+    }
+
+    if (filas != filasLocales)
+        free(filas);
+    return NULL;
+}
+
+// Adaptador para el pool: ejecuta convolucionHilo sobre [inicio, fin)
+static void convolucionRango(void *ctx, int inicio, int fin)
+{
+    ConvolucionArgs args = *(ConvolucionArgs *)ctx;
+    args.inicio = inicio;
+    args.fin = fin;
+    convolucionHilo(&args);
+    if (args.error)
+        ((ConvolucionArgs *)ctx)->error = 1;
+}
 
-                // Clamp el resultado entre 0-255
-                int resultado = (int)round(suma);
-                if (resultado < 0)
-                    resultado = 0;
-                if (resultado > 255)
-                    resultado = 255;
+void *convolucionHorizontalHilo(void *args)
+{
+    ConvolucionSeparableArgs *cArgs = (ConvolucionSeparableArgs *)args;
+    const NucleosSimd *simd = nucleosSimd();
+    const int centro = cArgs->tamKernel / 2;
+    const int canales = cArgs->canales;
+    const size_t bytesFila = (size_t)cArgs->ancho * canales;
 
-                cArgs->pixelesResultado[y][x][c] = (unsigned char)resultado;
+    // Columnas cuyos taps caen todos dentro de la fila: van al núcleo SIMD;
+    // solo los bordes necesitan replicar píxeles
+    int interiorIni = centro < cArgs->ancho ? centro : cArgs->ancho;
+    int interiorFin = cArgs->ancho - centro > interiorIni ? cArgs->ancho - centro : interiorIni;
+
+    for (int y = cArgs->inicio; y < cArgs->fin; y++)
+    {
+        const unsigned char *fila = cArgs->pixeles[y];
+        float *salida = cArgs->temporal + (size_t)y * bytesFila;
+
+        simd->convolucionHorizontalFila(fila, cArgs->kernel, cArgs->tamKernel, canales, salida,
+                                        (size_t)interiorIni * canales, (size_t)interiorFin * canales);
+
+        for (int x = 0; x < cArgs->ancho; x++)
+        {
+            if (x == interiorIni)
+                x = interiorFin;
+            if (x >= cArgs->ancho)
+                break;
+            for (int c = 0; c < canales; c++)
+            {
+                float suma = 0.0f;
+                for (int k = 0; k < cArgs->tamKernel; k++)
+                {
+                    // Manejo de bordes: replicar píxeles de borde
+                    int px = x + k - centro;
+                    if (px < 0)
+                        px = 0;
+                    if (px >= cArgs->ancho)
+                        px = cArgs->ancho - 1;
+                    suma += fila[(size_t)px * canales + c] * cArgs->kernel[k];
+                }
+                salida[(size_t)x * canales + c] = suma;
             }
         }
     }
@@ -128,177 +272,730 @@ void *convolucionHilo(void *args)
     return NULL;
 }
 
-int aplicarConvolucionConcurrente(ImagenInfo *info, int tamKernel, float sigma, int numHilos)
+void *convolucionVerticalHilo(void *args)
 {
-    if (!info->pixeles)
+    ConvolucionSeparableArgs *cArgs = (ConvolucionSeparableArgs *)args;
+    const NucleosSimd *simd = nucleosSimd();
+    const int centro = cArgs->tamKernel / 2;
+    const size_t bytesFila = (size_t)cArgs->ancho * cArgs->canales;
+
+    // Filas del buffer intermedio que toca cada tap (bordes replicados); en
+    // la pila salvo para kernels enormes, ya que se llama una vez por tesela
+    const float *filasLocales[64];
+    const float **filas = filasLocales;
+    if (cArgs->tamKernel > 64)
     {
-        fprintf(stderr, "No hay imagen cargada para aplicar convolución.\n");
-        return 0;
+        filas = (const float **)malloc(cArgs->tamKernel * sizeof(float *));
+        if (!filas)
+        {
+            fprintf(stderr, "Error de memoria en la pasada vertical\n");
+            cArgs->error = 1;
+            return NULL;
+        }
     }
 
-    if (tamKernel % 2 == 0)
+    for (int y = cArgs->inicio; y < cArgs->fin; y++)
     {
-        fprintf(stderr, "El tamaño del kernel debe ser impar (3, 5, 7, etc.)\n");
-        return 0;
+        for (int k = 0; k < cArgs->tamKernel; k++)
+        {
+            // Manejo de bordes: replicar filas de borde
+            int py = y + k - centro;
+            if (py < 0)
+                py = 0;
+            if (py >= cArgs->alto)
+                py = cArgs->alto - 1;
+            filas[k] = cArgs->temporal + (size_t)py * bytesFila;
+        }
+
+        simd->convolucionVerticalFila(filas, cArgs->kernel, cArgs->tamKernel,
+                                      cArgs->pixelesResultado[y], bytesFila);
     }
 
-    if (numHilos < 1 || numHilos > 4)
+    if (filas != filasLocales)
+        free(filas);
+    return NULL;
+}
+
+// Adaptadores para el pool de las dos pasadas separables
+static void convolucionHorizontalRango(void *ctx, int inicio, int fin)
+{
+    ConvolucionSeparableArgs args = *(ConvolucionSeparableArgs *)ctx;
+    args.inicio = inicio;
+    args.fin = fin;
+    convolucionHorizontalHilo(&args);
+}
+
+static void convolucionVerticalRango(void *ctx, int inicio, int fin)
+{
+    ConvolucionSeparableArgs args = *(ConvolucionSeparableArgs *)ctx;
+    args.inicio = inicio;
+    args.fin = fin;
+    convolucionVerticalHilo(&args);
+    if (args.error)
+        ((ConvolucionSeparableArgs *)ctx)->error = 1;
+}
+
+// ---------- Gaussiano recursivo (Young-van Vliet) ----------
+
+// Columnas de temporal que recorre cada tarea de la pasada vertical (4 KiB
+// de cada fila: menos páginas distintas por franja)
+#define FRANJA_RECURSIVA 1024
+
+// Filas que avanza a la vez la pasada horizontal y posiciones de cada tramo
+// traspuesto
+#define FILAS_GRUPO_RECURSIVO 8
+#define PASOS_BLOQUE_RECURSIVO 64
+
+// Coeficientes de Young y van Vliet (1995) para el parámetro q
+static void coeficientesDesdeQ(double q, CoeficientesRecursivos *coef)
+{
+    double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+    double b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+    double b2 = -(1.4281 * q * q + 1.26661 * q * q * q);
+    double b3 = 0.422205 * q * q * q;
+    coef->a[0] = b1 / b0;
+    coef->a[1] = b2 / b0;
+    coef->a[2] = b3 / b0;
+    coef->b = 1.0 - (coef->a[0] + coef->a[1] + coef->a[2]);
+}
+
+// Varianza de la respuesta completa (hacia delante + hacia atrás): el doble
+// de la de la respuesta causal, medida sobre su respuesta al impulso
+static double varianzaRecursiva(const CoeficientesRecursivos *coef)
+{
+    double w1 = 0.0, w2 = 0.0, w3 = 0.0, suma = 0.0, m1 = 0.0, m2 = 0.0;
+    for (int n = 0; n < (1 << 20); n++)
     {
-        fprintf(stderr, "Número de hilos debe estar entre 1 y 4\n");
-        return 0;
+        double w = (n == 0 ? coef->b : 0.0) + coef->a[0] * w1 + coef->a[1] * w2 + coef->a[2] * w3;
+        suma += w;
+        m1 += n * w;
+        m2 += (double)n * n * w;
+        w3 = w2;
+        w2 = w1;
+        w1 = w;
+        if (n > 3 && fabs(w1) + fabs(w2) + fabs(w3) < 1e-15)
+            break;
     }
+    double media = m1 / suma;
+    return 2.0 * (m2 / suma - media * media);
+}
 
-    // Generar kernel Gaussiano
-    float **kernel = generarKernelGaussiano(tamKernel, sigma);
-    if (!kernel)
+void calcularCoeficientesRecursivos(double sigma, CoeficientesRecursivos *coef)
+{
+    // Young y van Vliet (1995): q a partir de sigma. Su aproximación da una
+    // Gaussiana un 8-10 % más ancha, así que q se ajusta por bisección hasta
+    // que la varianza de la respuesta sea sigma^2.
+    double q = sigma >= 2.5 ? 0.98711 * sigma - 0.96330 : 3.97156 - 4.14554 * sqrt(1.0 - 0.26891 * sigma);
+    double qMin = 0.5 * q, qMax = 1.5 * q;
+    for (int i = 0; i < 60; i++)
     {
+        q = 0.5 * (qMin + qMax);
+        coeficientesDesdeQ(q, coef);
+        if (varianzaRecursiva(coef) > sigma * sigma)
+            qMax = q;
+        else
+            qMin = q;
+    }
+    coeficientesDesdeQ(0.5 * (qMin + qMax), coef);
+
+    // Estado inicial de la pasada hacia atrás (Triggs-Sdika). Más allá del
+    // borde la entrada es constante (u), así que las desviaciones d = w - u
+    // siguen la recursión homogénea y la salida hacia atrás e = y - u se
+    // obtiene filtrando esa cola desde donde ya es despreciable. Es lineal en
+    // las tres últimas desviaciones: se calcula la matriz una vez por sigma
+    // simulando cada vector de la base.
+    const double *a = coef->a;
+    int largo = 3;
+    {
+        double d1 = 1.0, d2 = 1.0, d3 = 1.0;
+        while (largo < (1 << 20) && fabs(d1) + fabs(d2) + fabs(d3) > 1e-13)
+        {
+            double d = a[0] * d1 + a[1] * d2 + a[2] * d3;
+            d3 = d2;
+            d2 = d1;
+            d1 = d;
+            largo++;
+        }
+    }
+    double *cola = (double *)malloc((size_t)largo * sizeof(double));
+    for (int k = 0; k < 3; k++)
+    {
+        double d1 = k == 0, d2 = k == 1, d3 = k == 2;
+        double e0 = 0.0, e1 = 0.0, e2 = 0.0;
+        if (cola)
+        {
+            for (int n = 0; n < largo; n++)
+            {
+                cola[n] = a[0] * d1 + a[1] * d2 + a[2] * d3;
+                d3 = d2;
+                d2 = d1;
+                d1 = cola[n];
+            }
+            double y1 = 0.0, y2 = 0.0, y3 = 0.0;
+            for (int n = largo - 1; n >= 0; n--)
+            {
+                double y = coef->b * cola[n] + a[0] * y1 + a[1] * y2 + a[2] * y3;
+                y3 = y2;
+                y2 = y1;
+                y1 = y;
+                if (n <= 2)
+                    *(n == 0 ? &e0 : (n == 1 ? &e1 : &e2)) = y;
+            }
+        }
+        // Sin memoria queda e = 0: estado estacionario (error solo en el borde)
+        coef->m[0][k] = e0;
+        coef->m[1][k] = e1;
+        coef->m[2][k] = e2;
+    }
+    free(cola);
+}
+
+static inline unsigned char redondearRecursivo(double v)
+{
+    if (v <= 0.0)
         return 0;
+    if (v >= 255.0)
+        return 255;
+    return (unsigned char)(v + 0.5);
+}
+
+// Estado inicial de la pasada hacia atrás para n columnas: s1..s3 llegan con
+// las tres últimas salidas hacia delante y salen con y[N], y[N+1], y[N+2]
+static void iniciarHaciaAtras(const CoeficientesRecursivos *k, const double *ultimo, double *s1, double *s2,
+                              double *s3, int n)
+{
+    for (int j = 0; j < n; j++)
+    {
+        const double u = ultimo[j];
+        const double d0 = s1[j] - u, d1 = s2[j] - u, d2 = s3[j] - u;
+        s1[j] = u + k->m[0][0] * d0 + k->m[0][1] * d1 + k->m[0][2] * d2;
+        s2[j] = u + k->m[1][0] * d0 + k->m[1][1] * d1 + k->m[1][2] * d2;
+        s3[j] = u + k->m[2][0] * d0 + k->m[2][1] * d1 + k->m[2][2] * d2;
+    }
+}
+
+// El paso deja la salida nueva en s3: pasa a ser s1 y las demás se corren
+static inline void rotarEstado(double **s1, double **s2, double **s3)
+{
+    double *nuevo = *s3;
+    *s3 = *s2;
+    *s2 = *s1;
+    *s1 = nuevo;
+}
+
+// Copia las posiciones [i0, i0 + pasos) de un grupo de filas a bloque
+// traspuesto (una fila de bloque por posición, un carril por fila y canal):
+// desde los bytes de origen o, si origen es NULL, desde temporal
+static inline void cargarGrupo(float *const *t, const unsigned char *const *origen, int filas, int canales,
+                               int i0, int pasos, float *bloque)
+{
+    const int carriles = filas * canales;
+    for (int r = 0; r < filas; r++)
+    {
+        const size_t o = (size_t)i0 * canales;
+        float *b = bloque + r * canales;
+        if (origen)
+        {
+            const unsigned char *x = origen[r] + o;
+            for (int p = 0; p < pasos; p++, b += carriles, x += canales)
+                for (int c = 0; c < canales; c++)
+                    b[c] = x[c];
+        }
+        else
+        {
+            const float *x = t[r] + o;
+            for (int p = 0; p < pasos; p++, b += carriles, x += canales)
+                for (int c = 0; c < canales; c++)
+                    b[c] = x[c];
+        }
     }
+}
 
-    // Crear matriz de resultado
-    unsigned char ***pixelesResultado = (unsigned char ***)malloc(info->alto * sizeof(unsigned char **));
-    if (!pixelesResultado)
+// Inversa de cargarGrupo: del bloque a las filas de temporal
+static inline void guardarGrupo(float *const *t, int filas, int canales, int i0, int pasos, const float *bloque)
+{
+    const int carriles = filas * canales;
+    for (int r = 0; r < filas; r++)
     {
-        fprintf(stderr, "Error de memoria al asignar matriz de resultado\n");
-        liberarKernel(kernel, tamKernel);
-        return 0;
+        float *x = t[r] + (size_t)i0 * canales;
+        const float *b = bloque + r * canales;
+        for (int p = 0; p < pasos; p++, b += carriles, x += canales)
+            for (int c = 0; c < canales; c++)
+                x[c] = b[c];
     }
+}
+
+// Con canales constante el compilador desenrolla el bucle de canales
+static void cargarGrupoCanales(float *const *t, const unsigned char *const *origen, int filas, int canales,
+                               int i0, int pasos, float *bloque)
+{
+    if (canales == 1)
+        cargarGrupo(t, origen, filas, 1, i0, pasos, bloque);
+    else if (canales == 3)
+        cargarGrupo(t, origen, filas, 3, i0, pasos, bloque);
+    else
+        cargarGrupo(t, origen, filas, canales, i0, pasos, bloque);
+}
+
+static void guardarGrupoCanales(float *const *t, int filas, int canales, int i0, int pasos, const float *bloque)
+{
+    if (canales == 1)
+        guardarGrupo(t, filas, 1, i0, pasos, bloque);
+    else if (canales == 3)
+        guardarGrupo(t, filas, 3, i0, pasos, bloque);
+    else
+        guardarGrupo(t, filas, canales, i0, pasos, bloque);
+}
+
+void *gaussianoRecursivoHorizontalHilo(void *args)
+{
+    GaussianoRecursivoArgs *g = (GaussianoRecursivoArgs *)args;
+    const NucleosSimd *simd = nucleosSimd();
+    const CoeficientesRecursivos *k = g->coef;
+    const double coef[4] = {k->b, k->a[0], k->a[1], k->a[2]};
+    const int canales = g->canales;
+    const int n = g->ancho;
+    const size_t elementosFila = (size_t)n * canales;
+
+    // La recursión a lo largo de una fila es secuencial: se avanzan a la vez
+    // FILAS_GRUPO_RECURSIVO filas x canales secuencias independientes. Para
+    // que sean columnas contiguas del núcleo recursivoFila, cada tramo de
+    // PASOS_BLOQUE_RECURSIVO posiciones se traspone a un bloque pequeño.
+    enum
+    {
+        MAX_CARRILES = FILAS_GRUPO_RECURSIVO * 4
+    };
+    float bloque[PASOS_BLOQUE_RECURSIVO * MAX_CARRILES];
+    double estado[3][MAX_CARRILES], ultimo[MAX_CARRILES];
 
-    for (int y = 0; y < info->alto; y++)
+    for (int y0 = g->inicio; y0 < g->fin; y0 += FILAS_GRUPO_RECURSIVO)
     {
-        pixelesResultado[y] = (unsigned char **)malloc(info->ancho * sizeof(unsigned char *));
-        if (!pixelesResultado[y])
+        const int filas = g->fin - y0 < FILAS_GRUPO_RECURSIVO ? g->fin - y0 : FILAS_GRUPO_RECURSIVO;
+        const int carriles = filas * canales;
+        const unsigned char *origen[FILAS_GRUPO_RECURSIVO];
+        float *t[FILAS_GRUPO_RECURSIVO];
+        for (int r = 0; r < filas; r++)
+        {
+            origen[r] = g->pixeles[y0 + r];
+            t[r] = g->temporal + (size_t)(y0 + r) * elementosFila;
+        }
+
+        // Hacia delante, con el borde izquierdo replicado hasta el infinito
+        double *s1 = estado[0], *s2 = estado[1], *s3 = estado[2];
+        for (int r = 0, l = 0; r < filas; r++)
+            for (int c = 0; c < canales; c++, l++)
+                s1[l] = s2[l] = s3[l] = origen[r][c];
+        for (int i0 = 0; i0 < n; i0 += PASOS_BLOQUE_RECURSIVO)
         {
-            fprintf(stderr, "Error de memoria al asignar fila de resultado\n");
-            // Limpiar memoria ya asignada
-            for (int i = 0; i < y; i++)
+            const int pasos = n - i0 < PASOS_BLOQUE_RECURSIVO ? n - i0 : PASOS_BLOQUE_RECURSIVO;
+            cargarGrupoCanales(t, origen, filas, canales, i0, pasos, bloque);
+            for (int p = 0; p < pasos; p++)
             {
-                free(pixelesResultado[i]);
+                float *b = bloque + (size_t)p * carriles;
+                simd->recursivoFila(b, s1, s2, s3, coef, b, carriles);
+                rotarEstado(&s1, &s2, &s3);
             }
-            free(pixelesResultado);
-            liberarKernel(kernel, tamKernel);
-            return 0;
+            guardarGrupoCanales(t, filas, canales, i0, pasos, bloque);
         }
 
-        for (int x = 0; x < info->ancho; x++)
+        // Hacia atrás, con el estado que deja el borde derecho replicado
+        for (int r = 0, l = 0; r < filas; r++)
+            for (int c = 0; c < canales; c++, l++)
+                ultimo[l] = origen[r][elementosFila - canales + c];
+        iniciarHaciaAtras(k, ultimo, s1, s2, s3, carriles);
+        for (int fin = n; fin > 0; fin -= PASOS_BLOQUE_RECURSIVO)
         {
-            pixelesResultado[y][x] = (unsigned char *)malloc(info->canales * sizeof(unsigned char));
-            if (!pixelesResultado[y][x])
+            const int i0 = fin > PASOS_BLOQUE_RECURSIVO ? fin - PASOS_BLOQUE_RECURSIVO : 0;
+            const int pasos = fin - i0;
+            cargarGrupoCanales(t, NULL, filas, canales, i0, pasos, bloque);
+            for (int p = pasos - 1; p >= 0; p--)
             {
-                fprintf(stderr, "Error de memoria al asignar píxel de resultado\n");
-                // Limpiar memoria ya asignada
-                for (int i = 0; i < y; i++)
-                {
-                    for (int j = 0; j < info->ancho; j++)
-                    {
-                        free(pixelesResultado[i][j]);
-                    }
-                    free(pixelesResultado[i]);
-                }
-                for (int j = 0; j < x; j++)
-                {
-                    free(pixelesResultado[y][j]);
-                }
-                free(pixelesResultado[y]);
-                free(pixelesResultado);
-                liberarKernel(kernel, tamKernel);
-                return 0;
+                float *b = bloque + (size_t)p * carriles;
+                simd->recursivoFila(b, s1, s2, s3, coef, b, carriles);
+                rotarEstado(&s1, &s2, &s3);
             }
+            guardarGrupoCanales(t, filas, canales, i0, pasos, bloque);
         }
     }
+    return NULL;
+}
 
-    // Configurar hilos
-    pthread_t *hilos = (pthread_t *)malloc(numHilos * sizeof(pthread_t));
-    ConvolucionArgs *args = (ConvolucionArgs *)malloc(numHilos * sizeof(ConvolucionArgs));
-
-    if (!hilos || !args)
+void *gaussianoRecursivoVerticalHilo(void *args)
+{
+    GaussianoRecursivoArgs *g = (GaussianoRecursivoArgs *)args;
+    const NucleosSimd *simd = nucleosSimd();
+    const CoeficientesRecursivos *k = g->coef;
+    const double coef[4] = {k->b, k->a[0], k->a[1], k->a[2]};
+    const size_t elementosFila = (size_t)g->ancho * g->canales;
+    const int alto = g->alto;
+
+    // Cada elemento de la fila es una columna independiente: la franja
+    // avanza fila a fila con un estado por columna
+    double estado[3][FRANJA_RECURSIVA], ultimo[FRANJA_RECURSIVA];
+
+    for (int franja = g->inicio; franja < g->fin; franja++)
     {
-        fprintf(stderr, "Error de memoria al asignar estructuras de hilos\n");
-        // Limpiar memoria
-        for (int y = 0; y < info->alto; y++)
+        const size_t j0 = (size_t)franja * FRANJA_RECURSIVA;
+        const int ancho = (int)(elementosFila - j0 < FRANJA_RECURSIVA ? elementosFila - j0 : FRANJA_RECURSIVA);
+        double *s1 = estado[0], *s2 = estado[1], *s3 = estado[2];
+
+        // Hacia delante (en el sitio sobre temporal), borde superior replicado
+        float *fila = g->temporal + j0;
+        for (int j = 0; j < ancho; j++)
+            s1[j] = s2[j] = s3[j] = fila[j];
+        for (int y = 0; y < alto; y++)
         {
-            for (int x = 0; x < info->ancho; x++)
-            {
-                free(pixelesResultado[y][x]);
-            }
-            free(pixelesResultado[y]);
+            fila = g->temporal + (size_t)y * elementosFila + j0;
+            if (y == alto - 1)
+                for (int j = 0; j < ancho; j++)
+                    ultimo[j] = fila[j];
+            simd->recursivoFila(fila, s1, s2, s3, coef, fila, ancho);
+            rotarEstado(&s1, &s2, &s3);
         }
-        free(pixelesResultado);
-        liberarKernel(kernel, tamKernel);
-        if (hilos)
-            free(hilos);
-        if (args)
-            free(args);
+
+        // Hacia atrás, redondeando cada fila al resultado
+        iniciarHaciaAtras(k, ultimo, s1, s2, s3, ancho);
+        for (int y = alto - 1; y >= 0; y--)
+        {
+            fila = g->temporal + (size_t)y * elementosFila + j0;
+            simd->recursivoFila(fila, s1, s2, s3, coef, fila, ancho);
+            rotarEstado(&s1, &s2, &s3);
+            unsigned char *destino = g->pixelesResultado[y] + j0;
+            for (int j = 0; j < ancho; j++)
+                destino[j] = redondearRecursivo(fila[j]);
+        }
+    }
+    return NULL;
+}
+
+// Adaptadores para el pool de las dos pasadas recursivas
+static void gaussianoRecursivoHorizontalRango(void *ctx, int inicio, int fin)
+{
+    GaussianoRecursivoArgs args = *(GaussianoRecursivoArgs *)ctx;
+    args.inicio = inicio;
+    args.fin = fin;
+    gaussianoRecursivoHorizontalHilo(&args);
+}
+
+static void gaussianoRecursivoVerticalRango(void *ctx, int inicio, int fin)
+{
+    GaussianoRecursivoArgs args = *(GaussianoRecursivoArgs *)ctx;
+    args.inicio = inicio;
+    args.fin = fin;
+    gaussianoRecursivoVerticalHilo(&args);
+}
+
+int aplicarGaussianoRecursivo(ImagenInfo *info, float sigma, int numHilos)
+{
+    if (!info->pixeles)
+    {
+        fprintf(stderr, "No hay imagen cargada para aplicar convolución.\n");
+        return 0;
+    }
+    if (!isfinite(sigma) || sigma < 0.5f)
+    {
+        fprintf(stderr, "El Gaussiano recursivo necesita sigma finito >= 0.5\n");
+        return 0;
+    }
+
+    numHilos = poolResolverHilos(numHilos);
+    CoeficientesRecursivos coef;
+    calcularCoeficientesRecursivos(sigma, &coef);
+
+    ImagenInfo resultado;
+    if (!crearImagen(&resultado, info->ancho, info->alto, info->canales))
+        return 0;
+    const size_t elementosFila = (size_t)info->ancho * info->canales;
+    float *temporal = (float *)malloc((size_t)info->alto * elementosFila * sizeof(float));
+    if (!temporal)
+    {
+        fprintf(stderr, "Error de memoria al asignar buffer intermedio\n");
+        liberarImagen(&resultado);
         return 0;
     }
 
-    int filasPorHilo = (int)ceil((double)info->alto / numHilos);
+    GaussianoRecursivoArgs args;
+    args.pixeles = info->pixeles;
+    args.pixelesResultado = resultado.pixeles;
+    args.temporal = temporal;
+    args.ancho = info->ancho;
+    args.alto = info->alto;
+    args.canales = info->canales;
+    args.coef = &coef;
+
+    // Horizontal: teselas de filas; vertical: franjas de columnas
+    poolParaleloForTeselas(info->alto, numHilos, FILAS_GRUPO_RECURSIVO, gaussianoRecursivoHorizontalRango, &args);
+    const int numFranjas = (int)((elementosFila + FRANJA_RECURSIVA - 1) / FRANJA_RECURSIVA);
+    poolParaleloFor(numFranjas, numHilos, gaussianoRecursivoVerticalRango, &args);
+
+    reemplazarImagen(info, &resultado);
+    free(temporal);
+
+    IMG_INFO("Desenfoque Gaussiano recursivo aplicado con %d hilos (sigma=%.2f, %s).\n",
+             numHilos, sigma, info->canales == 1 ? "grises" : "RGB");
+    return 1;
+}
+
+int desenfoqueUsaRecursivo(int tamKernel, float sigma)
+{
+    // Un kernel explícito más corto que +-3 sigma es un desenfoque distinto
+    // (Gaussiana truncada): solo el kernel separable da ese resultado
+    if (!(sigma >= SIGMA_UMBRAL_RECURSIVO))
+        return 0;
+    return tamKernel <= 0 || (float)tamKernel >= 2.0f * ceilf(3.0f * sigma) + 1.0f;
+}
+
+int aplicarConvolucionConcurrente(ImagenInfo *info, int tamKernel, float sigma, int numHilos)
+{
+    // Sigma grande: el kernel sería enorme, el recursivo cuesta lo mismo
+    if (desenfoqueUsaRecursivo(tamKernel, sigma))
+        return aplicarGaussianoRecursivo(info, sigma, numHilos);
+    return aplicarConvolucionSeparable(info, tamKernel, sigma, numHilos);
+}
 
-    // Crear y lanzar hilos
-    for (int i = 0; i < numHilos; i++)
+int aplicarConvolucionSeparable(ImagenInfo *info, int tamKernel, float sigma, int numHilos)
+{
+    if (!info->pixeles)
     {
-        args[i].pixeles = info->pixeles;
-        args[i].pixelesResultado = pixelesResultado;
-        args[i].inicio = i * filasPorHilo;
-        args[i].fin = (i + 1) * filasPorHilo < info->alto ? (i + 1) * filasPorHilo : info->alto;
-        args[i].ancho = info->ancho;
-        args[i].alto = info->alto;
-        args[i].canales = info->canales;
-        args[i].kernel = kernel;
-        args[i].tamKernel = tamKernel;
+        fprintf(stderr, "No hay imagen cargada para aplicar convolución.\n");
+        return 0;
+    }
 
-        if (pthread_create(&hilos[i], NULL, convolucionHilo, &args[i]) != 0)
+    if (!isfinite(sigma) || sigma <= 0.0f)
+    {
+        fprintf(stderr, "Sigma debe ser un número finito mayor que 0\n");
+        return 0;
+    }
+
+    // Automático: el kernel cubre +-3 sigma
+    if (tamKernel <= 0)
+        tamKernel = 2 * (int)ceilf(3.0f * sigma) + 1;
+
+    if (tamKernel % 2 == 0)
+    {
+        fprintf(stderr, "El tamaño del kernel debe ser impar (3, 5, 7, etc.)\n");
+        return 0;
+    }
+
+    // numHilos <= 0: usar el valor por defecto (-j, IMG_HILOS o CPUs)
+    numHilos = poolResolverHilos(numHilos);
+
+    // Generar kernel Gaussiano 1D: la Gaussiana es separable, así que se
+    // aplica como pasada horizontal + pasada vertical (2K en vez de K*K)
+    float *kernel = generarKernelGaussiano1D(tamKernel, sigma);
+    if (!kernel)
+    {
+        return 0;
+    }
+
+    // Crear imagen de resultado y buffer intermedio de la pasada horizontal
+    ImagenInfo resultado;
+    if (!crearImagen(&resultado, info->ancho, info->alto, info->canales))
+    {
+        free(kernel);
+        return 0;
+    }
+    float *temporal = (float *)malloc((size_t)info->alto * info->ancho * info->canales * sizeof(float));
+    if (!temporal)
+    {
+        fprintf(stderr, "Error de memoria al asignar buffer intermedio\n");
+        liberarImagen(&resultado);
+        free(kernel);
+        return 0;
+    }
+
+    // Repartir las filas de cada pasada en el pool de hilos
+    ConvolucionSeparableArgs args;
+    args.pixeles = info->pixeles;
+    args.pixelesResultado = resultado.pixeles;
+    args.temporal = temporal;
+    args.ancho = info->ancho;
+    args.alto = info->alto;
+    args.canales = info->canales;
+    args.kernel = kernel;
+    args.tamKernel = tamKernel;
+    args.error = 0;
+    const int filasPorTesela = poolFilasPorTesela((size_t)info->ancho * info->canales * sizeof(float));
+    poolParaleloForTeselas(info->alto, numHilos, filasPorTesela, convolucionHorizontalRango, &args);
+    poolParaleloForTeselas(info->alto, numHilos, filasPorTesela, convolucionVerticalRango, &args);
+
+    // Limpiar recursos
+    free(temporal);
+    free(kernel);
+    if (args.error)
+    {
+        liberarImagen(&resultado);
+        return 0;
+    }
+
+    // Reemplazar la imagen original con el resultado
+    reemplazarImagen(info, &resultado);
+
+    IMG_INFO("Convolución Gaussiana aplicada con %d hilos (kernel %dx%d, sigma=%.2f, %s).\n",
+             numHilos, tamKernel, tamKernel, sigma,
+             info->canales == 1 ? "grises" : "RGB");
+
+    return 1;
+}
+
+// ---------- Kernels definidos por el usuario ----------
+
+int kernelPorNombre(const char *nombre, int tam, KernelUsuario *kernel)
+{
+    static const float realce[9] = {0, -1, 0, -1, 5, -1, 0, -1, 0};
+    static const float relieve[9] = {-2, -1, 0, -1, 1, 1, 0, 1, 2};
+    static const float laplaciano[9] = {0, 1, 0, 1, -4, 1, 0, 1, 0};
+
+    const float *fijo = NULL;
+    if (strcmp(nombre, "sharpen") == 0)
+        fijo = realce;
+    else if (strcmp(nombre, "emboss") == 0)
+        fijo = relieve;
+    else if (strcmp(nombre, "laplacian") == 0)
+        fijo = laplaciano;
+    else if (strcmp(nombre, "box") == 0)
+    {
+        if (tam < 1 || tam > TAM_KERNEL_MAXIMO || tam % 2 == 0)
         {
-            fprintf(stderr, "Error al crear hilo %d\n", i);
-            // Limpiar memoria y salir
-            for (int y = 0; y < info->alto; y++)
-            {
-                for (int x = 0; x < info->ancho; x++)
-                {
-                    free(pixelesResultado[y][x]);
-                }
-                free(pixelesResultado[y]);
-            }
-            free(pixelesResultado);
-            liberarKernel(kernel, tamKernel);
-            free(hilos);
-            free(args);
+            fprintf(stderr, "box: tamaño impar entre 1 y %d\n", TAM_KERNEL_MAXIMO);
             return 0;
         }
+        kernel->tam = tam;
+        for (int i = 0; i < tam * tam; i++)
+            kernel->pesos[i] = 1.0f / (tam * tam);
+        return 1;
+    }
+    else
+    {
+        fprintf(stderr, "Kernel desconocido: %s (sharpen, emboss, laplacian, box)\n", nombre);
+        return 0;
     }
 
-    // Esperar a que todos los hilos terminen
-    for (int i = 0; i < numHilos; i++)
+    if (tam != 3)
     {
-        if (pthread_join(hilos[i], NULL) != 0)
-        {
-            fprintf(stderr, "Error al esperar hilo %d\n", i);
-        }
+        fprintf(stderr, "%s solo existe en 3x3\n", nombre);
+        return 0;
     }
+    kernel->tam = 3;
+    memcpy(kernel->pesos, fijo, sizeof(realce));
+    return 1;
+}
 
-    // Reemplazar la imagen original con el resultado
-    // Liberar imagen original
-    for (int y = 0; y < info->alto; y++)
+int leerKernelTexto(const char *texto, KernelUsuario *kernel)
+{
+    const int maximo = TAM_KERNEL_MAXIMO * TAM_KERNEL_MAXIMO;
+    int n = 0;
+    double divisor = 1.0;
+    int hayDivisor = 0;
+    const char *p = texto;
+    while (*p)
     {
-        for (int x = 0; x < info->ancho; x++)
+        if (*p == '#')
+        {
+            while (*p && *p != '\n')
+                p++;
+            continue;
+        }
+        if (strchr(" \t\r\n,;", *p))
         {
-            free(info->pixeles[y][x]);
+            p++;
+            continue;
         }
-        free(info->pixeles[y]);
+        if (*p == '/' && !hayDivisor && n > 0)
+        {
+            char *fin;
+            divisor = strtod(p + 1, &fin);
+            if (fin == p + 1 || divisor == 0.0)
+                break;
+            hayDivisor = 1;
+            p = fin;
+            continue;
+        }
+
+        char *fin;
+        double v = strtod(p, &fin);
+        if (fin == p || hayDivisor || n >= maximo)
+        {
+            n = -1; // carácter no numérico, número tras el divisor o demasiados
+            break;
+        }
+        kernel->pesos[n++] = (float)v;
+        p = fin;
     }
-    free(info->pixeles);
 
-    // Asignar resultado
-    info->pixeles = pixelesResultado;
+    int tam = 1;
+    while (tam * tam < n)
+        tam++;
+    if (n <= 0 || tam * tam != n || tam % 2 == 0 || *p)
+    {
+        fprintf(stderr, "Kernel inválido: se esperan N x N números (N impar, hasta %d)\n", TAM_KERNEL_MAXIMO);
+        return 0;
+    }
+    kernel->tam = tam;
+    for (int i = 0; i < n; i++)
+        kernel->pesos[i] = (float)(kernel->pesos[i] / divisor);
+    return 1;
+}
 
-    // Limpiar recursos
-    liberarKernel(kernel, tamKernel);
-    free(hilos);
-    free(args);
+int leerKernelArchivo(const char *ruta, KernelUsuario *kernel)
+{
+    FILE *f = fopen(ruta, "r");
+    if (!f)
+    {
+        fprintf(stderr, "No se pudo abrir el kernel: %s\n", ruta);
+        return 0;
+    }
+    // Un kernel de 15x15 con comentarios cabe de sobra
+    char texto[16384];
+    size_t leidos = fread(texto, 1, sizeof(texto) - 1, f);
+    int completo = feof(f);
+    fclose(f);
+    if (!completo)
+    {
+        fprintf(stderr, "Archivo de kernel demasiado grande: %s\n", ruta);
+        return 0;
+    }
+    texto[leidos] = '\0';
+    return leerKernelTexto(texto, kernel);
+}
+
+int aplicarKernelConcurrente(ImagenInfo *info, const float *pesos, int tamKernel, int numHilos)
+{
+    if (!info->pixeles)
+    {
+        fprintf(stderr, "No hay imagen cargada para aplicar convolución.\n");
+        return 0;
+    }
+    if (tamKernel < 1 || tamKernel % 2 == 0)
+    {
+        fprintf(stderr, "El tamaño del kernel debe ser impar (3, 5, 7, etc.)\n");
+        return 0;
+    }
 
-    printf("Convolución Gaussiana aplicada con %d hilos (kernel %dx%d, sigma=%.2f, %s).\n",
-           numHilos, tamKernel, tamKernel, sigma,
-           info->canales == 1 ? "grises" : "RGB");
+    KernelEntero kernel;
+    if (!cuantizarKernel(pesos, tamKernel, &kernel))
+        return 0;
+
+    ImagenInfo resultado;
+    if (!crearImagen(&resultado, info->ancho, info->alto, info->canales))
+    {
+        liberarKernelEntero(&kernel);
+        return 0;
+    }
+
+    numHilos = poolResolverHilos(numHilos);
+    ConvolucionArgs args = {info->pixeles, resultado.pixeles, 0, 0, info->ancho, info->alto, info->canales, &kernel, 0};
+    poolParaleloForTeselas(info->alto, numHilos, poolFilasPorTesela(info->paso), convolucionRango, &args);
+    if (args.error)
+    {
+        liberarImagen(&resultado);
+        liberarKernelEntero(&kernel);
+        return 0;
+    }
 
+    reemplazarImagen(info, &resultado);
+    IMG_INFO("Kernel %dx%d aplicado con %d hilos (pesos enteros / 2^%d, %s).\n", tamKernel, tamKernel,
+             numHilos, kernel.desplazamiento, info->canales == 1 ? "grises" : "RGB");
+    liberarKernelEntero(&kernel);
     return 1;
 }
\ No newline at end of file
@@ -2,36 +2,161 @@
 #define CONVOLUTION_H
 
 // Include necessary headers
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "imagen_info.h"
 
 // Function declarations for convolution operations
 
+// Kernel 2D cuantizado a enteros: peso real = pesos[i] / 2^desplazamiento.
+// La convolución acumula pixel * peso en int32 y redondea con un
+// desplazamiento; el desplazamiento se elige lo más grande posible sin que
+// ningún peso salga de int16 ni la suma de int32.
+typedef struct
+{
+    int tam;
+    int desplazamiento;
+    int16_t *pesos; // tam * tam, fila a fila (contiguo)
+    int32_t *pares; // por fila, (tam + 1) / 2 pares de pesos consecutivos para el núcleo SIMD
+    double cotaError; // diferencia máxima con la suma en real antes de redondear (niveles)
+} KernelEntero;
+
+// Lado máximo de los kernels definidos por el usuario
+#define TAM_KERNEL_MAXIMO 15
+
+// Kernel 2D en real (fila a fila) antes de cuantizar
+typedef struct
+{
+    int tam;
+    float pesos[TAM_KERNEL_MAXIMO * TAM_KERNEL_MAXIMO];
+} KernelUsuario;
+
 // Estructura para pasar datos a los hilos de convolución
 typedef struct
 {
-    unsigned char ***pixeles;
-    unsigned char ***pixelesResultado;
+    unsigned char **pixeles;
+    unsigned char **pixelesResultado;
     int inicio;
     int fin;
     int ancho;
     int alto;
     int canales;
-    float **kernel;
-    int tamKernel;
+    const KernelEntero *kernel;
+    int error; // algún hilo se quedó sin memoria (filas sin escribir)
 } ConvolucionArgs;
 
-// Función para generar kernel Gaussiano
-float **generarKernelGaussiano(int tamKernel, float sigma);
+// Estructura para los hilos de la convolución separable (dos pasadas 1D).
+// La pasada horizontal escribe en temporal (float) y la vertical lee de ahí.
+typedef struct
+{
+    unsigned char **pixeles;
+    unsigned char **pixelesResultado;
+    float *temporal; // alto * ancho * canales
+    int inicio;
+    int fin;
+    int ancho;
+    int alto;
+    int canales;
+    const float *kernel; // kernel 1D de tamKernel elementos
+    int tamKernel;
+    int error; // ídem ConvolucionArgs
+} ConvolucionSeparableArgs;
+
+// Sigma a partir de la cual el desenfoque usa el filtro recursivo (coste
+// por píxel constante) en lugar del kernel
+#define SIGMA_UMBRAL_RECURSIVO 4.0f
 
-// Función para liberar memoria del kernel
-void liberarKernel(float **kernel, int tamKernel);
+// Coeficientes del Gaussiano recursivo de Young-van Vliet:
+// w[n] = b * x[n] + a[0] * w[n-1] + a[1] * w[n-2] + a[2] * w[n-3]
+// (y lo mismo hacia atrás). m lleva las tres últimas salidas de la pasada
+// hacia delante al estado inicial de la pasada hacia atrás con bordes
+// replicados (Triggs-Sdika).
+typedef struct
+{
+    double b;
+    double a[3];
+    double m[3][3];
+} CoeficientesRecursivos;
 
-// Función que ejecuta cada hilo para convolución
+// Estructura para los hilos del Gaussiano recursivo. La pasada horizontal
+// reparte filas y la vertical franjas de columnas de temporal.
+typedef struct
+{
+    unsigned char **pixeles;
+    unsigned char **pixelesResultado;
+    float *temporal; // alto * ancho * canales
+    int inicio;
+    int fin;
+    int ancho;
+    int alto;
+    int canales;
+    const CoeficientesRecursivos *coef;
+} GaussianoRecursivoArgs;
+
+// Cuantiza un kernel de tam x tam pesos (fila a fila). El redondeo se
+// corrige en el peso mayor para que la suma cuantizada sea la más cercana a
+// la real (una zona plana no cambia). Devuelve 0 si los pesos no caben.
+int cuantizarKernel(const float *pesos, int tam, KernelEntero *kernel);
+void liberarKernelEntero(KernelEntero *kernel);
+
+// Función para generar kernel Gaussiano 1D normalizado (liberar con free)
+float *generarKernelGaussiano1D(int tamKernel, float sigma);
+
+// Función que ejecuta cada hilo para convolución 2D completa
 void *convolucionHilo(void *args);
 
-// Función principal de convolución concurrente
+// Pasadas de la convolución separable: horizontal (pixeles -> temporal)
+// y vertical (temporal -> pixelesResultado)
+void *convolucionHorizontalHilo(void *args);
+void *convolucionVerticalHilo(void *args);
+
+// Kernels predefinidos: "sharpen" (realce), "emboss" (relieve) y "laplacian"
+// son de 3x3; "box" (media) admite cualquier tam impar hasta
+// TAM_KERNEL_MAXIMO. El laplaciano no se desplaza: los valores negativos
+// quedan en 0. Devuelve 0 si el nombre o el tamaño no son válidos.
+int kernelPorNombre(const char *nombre, int tam, KernelUsuario *kernel);
+
+// Lee un kernel de texto: tam * tam números (tam impar) separados por
+// espacios, saltos de línea, comas o ';', opcionalmente seguidos de
+// "/divisor". Lo que sigue a '#' hasta el final de la línea se ignora.
+// Devuelve 0 si el texto no es un kernel válido.
+int leerKernelTexto(const char *texto, KernelUsuario *kernel);
+
+// Igual que leerKernelTexto con el contenido de un archivo
+int leerKernelArchivo(const char *ruta, KernelUsuario *kernel);
+
+// Convolución 2D con un kernel cuantizado arbitrario (tam impar, bordes
+// replicados). El resultado difiere del cálculo en real a lo sumo en
+// floor(cotaError) + 1 niveles. Devuelve 1 si se aplicó.
+int aplicarKernelConcurrente(ImagenInfo *info, const float *pesos, int tamKernel, int numHilos);
+
+// Calcula los coeficientes recursivos para sigma (>= 0.5)
+void calcularCoeficientesRecursivos(double sigma, CoeficientesRecursivos *coef);
+
+// Pasadas del Gaussiano recursivo: filas [inicio, fin) (pixeles -> temporal)
+// y franjas de columnas [inicio, fin) (temporal -> pixelesResultado)
+void *gaussianoRecursivoHorizontalHilo(void *args);
+void *gaussianoRecursivoVerticalHilo(void *args);
+
+// Desenfoque Gaussiano recursivo: el coste por píxel no depende de sigma
+// (>= 0.5). Devuelve 1 si se aplicó.
+int aplicarGaussianoRecursivo(ImagenInfo *info, float sigma, int numHilos);
+
+// Devuelve 1 si aplicarConvolucionConcurrente usará el filtro recursivo:
+// sigma >= SIGMA_UMBRAL_RECURSIVO y tamKernel automático (<= 0) o de al
+// menos 2 * ceil(3 * sigma) + 1 (el kernel ya cubre toda la Gaussiana).
+int desenfoqueUsaRecursivo(int tamKernel, float sigma);
+
+// Función principal de convolución concurrente (desenfoque Gaussiano separable).
+// tamKernel <= 0 lo elige a partir de sigma (2 * ceil(3 * sigma) + 1). Si
+// desenfoqueUsaRecursivo lo indica se usa el filtro recursivo; un tamKernel
+// explícito más pequeño se respeta con el kernel separable.
 int aplicarConvolucionConcurrente(ImagenInfo *info, int tamKernel, float sigma, int numHilos);
 
+// Desenfoque Gaussiano con el kernel separable para cualquier sigma
+// (tamKernel <= 0 automático). Cada fila solo depende de tamKernel / 2 filas
+// vecinas, lo que permite procesar la imagen por franjas.
+int aplicarConvolucionSeparable(ImagenInfo *info, int tamKernel, float sigma, int numHilos);
+
 #endif // CONVOLUTION_H
\ No newline at end of file
@@ -0,0 +1,225 @@
+// Volteos, 180° y transposición en el sitio
+
+#include "flip.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include <stdio.h>
+#include <string.h>
+
+// Lado de los bloques que se intercambian al transponer (dos bloques de
+// 32x32 caben a la vez en la L1)
+#define BLOQUE_TRANSPOSICION 32
+
+static void invertirFila(unsigned char *fila, int ancho, int canales)
+{
+    unsigned char *a = fila;
+    unsigned char *b = fila + (size_t)(ancho - 1) * canales;
+    if (canales == 1)
+    {
+        for (; a < b; a++, b--)
+        {
+            unsigned char t = *a;
+            *a = *b;
+            *b = t;
+        }
+        return;
+    }
+    for (; a < b; a += canales, b -= canales)
+    {
+        for (int c = 0; c < canales; c++)
+        {
+            unsigned char t = a[c];
+            a[c] = b[c];
+            b[c] = t;
+        }
+    }
+}
+
+void *voltearHorizontalHilo(void *args)
+{
+    VolteoArgs *v = (VolteoArgs *)args;
+    for (int y = v->inicio; y < v->fin; y++)
+        invertirFila(v->pixeles[y], v->ancho, v->canales);
+    return NULL;
+}
+
+// Adaptador para el pool: ejecuta voltearHorizontalHilo sobre [inicio, fin)
+static void voltearHorizontalRango(void *ctx, int inicio, int fin)
+{
+    VolteoArgs args = *(VolteoArgs *)ctx;
+    args.inicio = inicio;
+    args.fin = fin;
+    voltearHorizontalHilo(&args);
+}
+
+static void invertirFilas(ImagenInfo *info)
+{
+    for (int a = 0, b = info->alto - 1; a < b; a++, b--)
+    {
+        unsigned char *t = info->pixeles[a];
+        info->pixeles[a] = info->pixeles[b];
+        info->pixeles[b] = t;
+    }
+}
+
+int voltearHorizontal(ImagenInfo *info, int numHilos)
+{
+    if (!info->pixeles)
+    {
+        fprintf(stderr, "No hay imagen cargada.\n");
+        return 0;
+    }
+
+    numHilos = poolResolverHilos(numHilos);
+    VolteoArgs args = {info->pixeles, info->ancho, info->canales, 0, 0};
+    poolParaleloForTeselas(info->alto, numHilos, poolFilasPorTesela(info->paso), voltearHorizontalRango, &args);
+    IMG_INFO("Imagen volteada horizontalmente con %d hilos.\n", numHilos);
+    return 1;
+}
+
+int voltearVertical(ImagenInfo *info)
+{
+    if (!info->pixeles)
+    {
+        fprintf(stderr, "No hay imagen cargada.\n");
+        return 0;
+    }
+
+    invertirFilas(info);
+    IMG_INFO("Imagen volteada verticalmente.\n");
+    return 1;
+}
+
+int rotar180EnSitio(ImagenInfo *info, int numHilos)
+{
+    if (!info->pixeles)
+    {
+        fprintf(stderr, "No hay imagen cargada.\n");
+        return 0;
+    }
+
+    invertirFilas(info);
+    numHilos = poolResolverHilos(numHilos);
+    VolteoArgs args = {info->pixeles, info->ancho, info->canales, 0, 0};
+    poolParaleloForTeselas(info->alto, numHilos, poolFilasPorTesela(info->paso), voltearHorizontalRango, &args);
+    IMG_INFO("Imagen rotada 180 grados en el sitio con %d hilos.\n", numHilos);
+    return 1;
+}
+
+// Intercambia el bloque de filas [y0, y1) x columnas [x0, x1) con su
+// simétrico respecto a la diagonal. En un bloque diagonal (y0 == x0) solo
+// se recorre la parte por encima de la diagonal.
+static void intercambiarBloque(unsigned char **p, int canales, int y0, int y1, int x0, int x1)
+{
+    for (int y = y0; y < y1; y++)
+    {
+        for (int x = (x0 == y0 ? y + 1 : x0); x < x1; x++)
+        {
+            unsigned char *a = p[y] + (size_t)x * canales;
+            unsigned char *b = p[x] + (size_t)y * canales;
+            for (int c = 0; c < canales; c++)
+            {
+                unsigned char t = a[c];
+                a[c] = b[c];
+                b[c] = t;
+            }
+        }
+    }
+}
+
+// Grises: igual que intercambiarBloque para un bloque de lado múltiplo de 8,
+// transponiendo sub-bloques de 8x8 en registros
+static void intercambiarBloque8x8(unsigned char **p, int y0, int y1, int x0, int x1)
+{
+    const NucleosSimd *simd = nucleosSimd();
+    unsigned char tmp[8][8];
+    const unsigned char *origen[8];
+    unsigned char *destino[8];
+    unsigned char *filasTmp[8];
+    for (int k = 0; k < 8; k++)
+        filasTmp[k] = tmp[k];
+
+    for (int y = y0; y < y1; y += 8)
+    {
+        for (int x = (x0 == y0 ? y : x0); x < x1; x += 8)
+        {
+            // tmp = T(A), A = T(B), B = tmp; A en (y, x) y B en (x, y)
+            for (int k = 0; k < 8; k++)
+                origen[k] = p[y + k] + x;
+            simd->transponer8x8(origen, filasTmp);
+            if (x != y)
+            {
+                for (int k = 0; k < 8; k++)
+                {
+                    origen[k] = p[x + k] + y;
+                    destino[k] = p[y + k] + x;
+                }
+                simd->transponer8x8(origen, destino);
+            }
+            for (int k = 0; k < 8; k++)
+                memcpy(p[x + k] + y, tmp[k], 8);
+        }
+    }
+}
+
+// Transpone las filas de bloques [inicio, fin): la fila de bloques bi se
+// encarga de los pares (bi, bj) y (bj, bi) con bj >= bi, así dos filas de
+// bloques distintas nunca tocan los mismos píxeles.
+static void transponerRango(void *ctx, int inicio, int fin)
+{
+    const VolteoArgs *v = (const VolteoArgs *)ctx;
+    const int lado = v->ancho;
+    // En grises la parte múltiplo de 8 va por el núcleo SIMD y las últimas
+    // lado % 8 filas/columnas por la copia escalar
+    const int lado8 = v->canales == 1 ? lado & ~7 : 0;
+    const int limite = v->canales == 1 ? lado8 : lado;
+
+    for (int bi = inicio; bi < fin; bi++)
+    {
+        const int y0 = bi * BLOQUE_TRANSPOSICION;
+        const int y1 = y0 + BLOQUE_TRANSPOSICION < limite ? y0 + BLOQUE_TRANSPOSICION : limite;
+        for (int x0 = y0; x0 < limite; x0 += BLOQUE_TRANSPOSICION)
+        {
+            const int x1 = x0 + BLOQUE_TRANSPOSICION < limite ? x0 + BLOQUE_TRANSPOSICION : limite;
+            if (v->canales == 1)
+                intercambiarBloque8x8(v->pixeles, y0, y1, x0, x1);
+            else
+                intercambiarBloque(v->pixeles, v->canales, y0, y1, x0, x1);
+        }
+        // Franja de las columnas [lado8, lado) de estas filas
+        if (lado8 < lado && y0 < lado8)
+            intercambiarBloque(v->pixeles, 1, y0, y1, lado8, lado);
+    }
+
+    // La esquina final la resuelve la última fila de bloques
+    const int numBloques = (limite + BLOQUE_TRANSPOSICION - 1) / BLOQUE_TRANSPOSICION;
+    if (lado8 < lado && v->canales == 1 && fin >= numBloques)
+        intercambiarBloque(v->pixeles, 1, lado8, lado, lado8, lado);
+}
+
+int transponerEnSitio(ImagenInfo *info, int numHilos)
+{
+    if (!info->pixeles)
+    {
+        fprintf(stderr, "No hay imagen cargada.\n");
+        return 0;
+    }
+    if (info->ancho != info->alto)
+    {
+        fprintf(stderr, "La transposición en el sitio requiere una imagen cuadrada (%dx%d).\n",
+                info->ancho, info->alto);
+        return 0;
+    }
+
+    numHilos = poolResolverHilos(numHilos);
+    VolteoArgs args = {info->pixeles, info->ancho, info->canales, 0, 0};
+    const int limite = info->canales == 1 ? info->ancho & ~7 : info->ancho;
+    int numBloques = (limite + BLOQUE_TRANSPOSICION - 1) / BLOQUE_TRANSPOSICION;
+    if (numBloques == 0)
+        numBloques = 1; // imagen de menos de 8 píxeles de lado: solo la esquina
+    // Cada tarea es una fila de bloques; las primeras tienen más trabajo,
+    // el robo de teselas reparte el resto
+    poolParaleloForTeselas(numBloques, numHilos, 1, transponerRango, &args);
+    IMG_INFO("Imagen transpuesta en el sitio con %d hilos.\n", numHilos);
+    return 1;
+}
@@ -0,0 +1,37 @@
+#ifndef FLIP_H
+#define FLIP_H
+
+#include "imagen_info.h"
+
+// Volteos y transposición en el sitio: no reservan memoria, reordenan los
+// píxeles (o los punteros a filas) de la propia imagen.
+
+typedef struct
+{
+    unsigned char **pixeles;
+    int ancho;
+    int canales;
+    int inicio;
+    int fin;
+} VolteoArgs;
+
+// Espejo izquierda-derecha de las filas [inicio, fin)
+void *voltearHorizontalHilo(void *args);
+
+// Espejo izquierda-derecha. numHilos <= 0 usa el número de hilos por defecto
+// del pool. Devuelve 1 si se aplicó, 0 si hubo error.
+int voltearHorizontal(ImagenInfo *info, int numHilos);
+
+// Espejo arriba-abajo: solo invierte el arreglo de punteros a filas (no
+// mueve píxeles; las filas ya no siguen el orden de datos, por eso todo el
+// código, incluido el guardado, recorre la imagen por pixeles).
+int voltearVertical(ImagenInfo *info);
+
+// Rotación de 180° = volteo vertical + horizontal
+int rotar180EnSitio(ImagenInfo *info, int numHilos);
+
+// Transpone una imagen cuadrada (pixel (x, y) <-> (y, x)) intercambiando
+// bloques a ambos lados de la diagonal. Devuelve 0 si no es cuadrada.
+int transponerEnSitio(ImagenInfo *info, int numHilos);
+
+#endif // FLIP_H
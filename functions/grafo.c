@@ -0,0 +1,428 @@
+// Grafo de operaciones: cola de nodos y planificador que los agrupa en
+// cadenas de etapas por franjas (stream.c) separadas por barreras.
+
+#include "grafo.h"
+#include "border.h"
+#include "brightness.h"
+#include "convolution.h"
+#include "flip.h"
+#include "resize.h"
+#include "rotation.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum
+{
+    NODO_BRILLO,
+    NODO_LUT,
+    NODO_GRISES,
+    NODO_DESENFOQUE,
+    NODO_KERNEL,
+    NODO_SOBEL,
+    NODO_RESIZE,
+    NODO_VOLTEO_H,
+    NODO_VOLTEO_V,
+    NODO_ROTAR,
+    NODO_TRANSPONER
+} TipoNodo;
+
+typedef struct
+{
+    TipoNodo tipo;
+    int delta;              // brillo
+    LutPuntual lut;         // lut
+    int tamKernel;          // desenfoque
+    float sigma;            // desenfoque
+    KernelUsuario kernel;   // kernel (copia de los pesos)
+    int ancho, alto;        // resize
+    int filtro;             // resize
+    float angulo;           // rotar
+    unsigned char fondo[3]; // rotar
+} NodoGrafo;
+
+struct GrafoOperaciones
+{
+    NodoGrafo *nodos;
+    int numNodos;
+    int capacidad;
+};
+
+GrafoOperaciones *grafoCrear(void)
+{
+    return (GrafoOperaciones *)calloc(1, sizeof(GrafoOperaciones));
+}
+
+void grafoLiberar(GrafoOperaciones *grafo)
+{
+    if (!grafo)
+        return;
+    free(grafo->nodos);
+    free(grafo);
+}
+
+int grafoNumOperaciones(const GrafoOperaciones *grafo)
+{
+    return grafo->numNodos;
+}
+
+// Reserva un nodo nuevo al final de la cola (en ceros)
+static NodoGrafo *nuevoNodo(GrafoOperaciones *grafo, TipoNodo tipo)
+{
+    if (grafo->numNodos == grafo->capacidad)
+    {
+        int capacidad = grafo->capacidad ? grafo->capacidad * 2 : 8;
+        NodoGrafo *nodos = (NodoGrafo *)realloc(grafo->nodos, (size_t)capacidad * sizeof(NodoGrafo));
+        if (!nodos)
+        {
+            fprintf(stderr, "Error de memoria al encolar la operación\n");
+            return NULL;
+        }
+        grafo->nodos = nodos;
+        grafo->capacidad = capacidad;
+    }
+    NodoGrafo *nodo = &grafo->nodos[grafo->numNodos++];
+    memset(nodo, 0, sizeof(*nodo));
+    nodo->tipo = tipo;
+    return nodo;
+}
+
+int grafoBrillo(GrafoOperaciones *grafo, int delta)
+{
+    NodoGrafo *nodo = nuevoNodo(grafo, NODO_BRILLO);
+    if (!nodo)
+        return 0;
+    nodo->delta = delta;
+    return 1;
+}
+
+int grafoLut(GrafoOperaciones *grafo, const LutPuntual *lut)
+{
+    NodoGrafo *nodo = nuevoNodo(grafo, NODO_LUT);
+    if (!nodo)
+        return 0;
+    nodo->lut = *lut;
+    return 1;
+}
+
+int grafoGrises(GrafoOperaciones *grafo)
+{
+    return nuevoNodo(grafo, NODO_GRISES) != NULL;
+}
+
+int grafoDesenfoque(GrafoOperaciones *grafo, int tamKernel, float sigma)
+{
+    if (!(sigma > 0.0f))
+    {
+        fprintf(stderr, "Sigma debe ser mayor que 0\n");
+        return 0;
+    }
+    NodoGrafo *nodo = nuevoNodo(grafo, NODO_DESENFOQUE);
+    if (!nodo)
+        return 0;
+    nodo->tamKernel = tamKernel;
+    nodo->sigma = sigma;
+    return 1;
+}
+
+int grafoKernel(GrafoOperaciones *grafo, const float *pesos, int tam)
+{
+    if (tam < 1 || tam % 2 == 0 || tam > TAM_KERNEL_MAXIMO)
+    {
+        fprintf(stderr, "El kernel debe ser de lado impar entre 1 y %d\n", TAM_KERNEL_MAXIMO);
+        return 0;
+    }
+    NodoGrafo *nodo = nuevoNodo(grafo, NODO_KERNEL);
+    if (!nodo)
+        return 0;
+    nodo->kernel.tam = tam;
+    memcpy(nodo->kernel.pesos, pesos, (size_t)tam * tam * sizeof(float));
+    return 1;
+}
+
+int grafoSobel(GrafoOperaciones *grafo)
+{
+    return nuevoNodo(grafo, NODO_SOBEL) != NULL;
+}
+
+int grafoResize(GrafoOperaciones *grafo, int ancho, int alto, int filtro)
+{
+    if (ancho <= 0 || alto <= 0)
+    {
+        fprintf(stderr, "Tamaño de destino inválido (%d x %d).\n", ancho, alto);
+        return 0;
+    }
+    NodoGrafo *nodo = nuevoNodo(grafo, NODO_RESIZE);
+    if (!nodo)
+        return 0;
+    nodo->ancho = ancho;
+    nodo->alto = alto;
+    nodo->filtro = filtro < 0 ? -1 : filtro;
+    return 1;
+}
+
+int grafoVoltear(GrafoOperaciones *grafo, char eje)
+{
+    if (eje != 'h' && eje != 'v')
+    {
+        fprintf(stderr, "Eje de volteo inválido: %c\n", eje);
+        return 0;
+    }
+    return nuevoNodo(grafo, eje == 'h' ? NODO_VOLTEO_H : NODO_VOLTEO_V) != NULL;
+}
+
+int grafoRotar(GrafoOperaciones *grafo, float angulo, const unsigned char fondo[3])
+{
+    NodoGrafo *nodo = nuevoNodo(grafo, NODO_ROTAR);
+    if (!nodo)
+        return 0;
+    nodo->angulo = angulo;
+    memcpy(nodo->fondo, fondo, 3);
+    return 1;
+}
+
+int grafoTransponer(GrafoOperaciones *grafo)
+{
+    return nuevoNodo(grafo, NODO_TRANSPONER) != NULL;
+}
+
+// ---------- Planificador ----------
+
+// Operaciones que necesitan la imagen entera (cortan la cadena por franjas).
+// El desenfoque recursivo lo es en los dos modos: si por franjas se cambiara
+// por el kernel, el resultado dependería del modo.
+static int esBarrera(const NodoGrafo *nodo)
+{
+    switch (nodo->tipo)
+    {
+    case NODO_VOLTEO_V:
+    case NODO_ROTAR:
+    case NODO_TRANSPONER:
+        return 1;
+    case NODO_DESENFOQUE:
+        return desenfoqueUsaRecursivo(nodo->tamKernel, nodo->sigma);
+    default:
+        return 0;
+    }
+}
+
+// Compone la tabla b después de a en todos los canales
+static void componerTablas(LutPuntual *a, const LutPuntual *b)
+{
+    for (int c = 0; c < LUT_MAX_CANALES; c++)
+        lutComponer(a, c, b->tabla[c]);
+}
+
+// Traduce los nodos desde *inicio hasta la siguiente barrera (o el final) a
+// etapas fundidas y deja en *inicio el índice de la barrera.
+static void planificarTramo(const GrafoOperaciones *grafo, int *inicio, EtapaFranjas *etapas, int *numEtapas)
+{
+    LutPuntual pendiente;
+    int numPuntuales = 0; // operaciones puntuales en pendiente
+    int soloBrillo = 0;   // pendiente es un único brillo
+    int n = 0;
+    int i = *inicio;
+
+    for (; i < grafo->numNodos && !esBarrera(&grafo->nodos[i]); i++)
+    {
+        const NodoGrafo *nodo = &grafo->nodos[i];
+
+        // Las puntuales se acumulan hasta la siguiente etapa
+        if (nodo->tipo == NODO_BRILLO || nodo->tipo == NODO_LUT)
+        {
+            if (numPuntuales == 0)
+                lutIdentidad(&pendiente);
+            if (nodo->tipo == NODO_BRILLO)
+                lutBrillo(&pendiente, nodo->delta);
+            else
+                componerTablas(&pendiente, &nodo->lut);
+            soloBrillo = numPuntuales == 0 && nodo->tipo == NODO_BRILLO;
+            numPuntuales++;
+            continue;
+        }
+
+        // Grises justo antes de Sobel: Sobel ya calcula ese gris
+        if (nodo->tipo == NODO_SOBEL && numPuntuales == 0 && n > 0 && etapas[n - 1].tipo == ETAPA_GRISES)
+        {
+            etapas[n - 1].tipo = ETAPA_SOBEL;
+            continue;
+        }
+
+        EtapaFranjas *etapa = &etapas[n++];
+        memset(etapa, 0, sizeof(*etapa));
+        switch (nodo->tipo)
+        {
+        case NODO_GRISES:
+            etapa->tipo = ETAPA_GRISES;
+            break;
+        case NODO_DESENFOQUE:
+            etapa->tipo = ETAPA_DESENFOQUE;
+            etapa->tamKernel = nodo->tamKernel;
+            etapa->sigma = nodo->sigma;
+            break;
+        case NODO_KERNEL:
+            etapa->tipo = ETAPA_KERNEL;
+            etapa->kernel = &nodo->kernel;
+            break;
+        case NODO_SOBEL:
+            etapa->tipo = ETAPA_SOBEL;
+            break;
+        case NODO_RESIZE:
+            etapa->tipo = ETAPA_RESIZE;
+            etapa->ancho = nodo->ancho;
+            etapa->alto = nodo->alto;
+            etapa->filtro = nodo->filtro;
+            break;
+        default: // NODO_VOLTEO_H
+            etapa->tipo = ETAPA_VOLTEO_H;
+            break;
+        }
+
+        // La tabla acumulada se aplica al copiar las filas de entrada
+        if (numPuntuales > 0)
+        {
+            etapa->fundirLut = 1;
+            etapa->lut = pendiente;
+            numPuntuales = 0;
+        }
+    }
+
+    // Puntuales al final del tramo: una pasada propia
+    if (numPuntuales > 0)
+    {
+        EtapaFranjas *etapa = &etapas[n++];
+        memset(etapa, 0, sizeof(*etapa));
+        if (numPuntuales == 1 && soloBrillo)
+        {
+            etapa->tipo = ETAPA_BRILLO;
+            etapa->delta = grafo->nodos[i - 1].delta;
+        }
+        else
+        {
+            etapa->tipo = ETAPA_LUT;
+            etapa->lut = pendiente;
+        }
+    }
+
+    *inicio = i;
+    *numEtapas = n;
+}
+
+// ---------- Ejecución ----------
+
+// Una etapa sola sin nada fundido: la función de imagen completa de siempre
+static int aplicarEtapa(ImagenInfo *info, const EtapaFranjas *etapa, int numHilos)
+{
+    switch (etapa->tipo)
+    {
+    case ETAPA_LUT:
+        return aplicarLutConcurrente(info, &etapa->lut, numHilos);
+    case ETAPA_BRILLO:
+        return ajustarBrilloConcurrente(info, etapa->delta, numHilos);
+    case ETAPA_DESENFOQUE:
+        return aplicarConvolucionSeparable(info, etapa->tamKernel, etapa->sigma, numHilos);
+    case ETAPA_KERNEL:
+        return aplicarKernelConcurrente(info, etapa->kernel->pesos, etapa->kernel->tam, numHilos);
+    case ETAPA_SOBEL:
+        return detectarBordesSobel(info, numHilos);
+    case ETAPA_RESIZE:
+        if (etapa->filtro >= 0)
+            return resizeFiltradoConcurrente(info, etapa->ancho, etapa->alto, (FiltroResize)etapa->filtro, numHilos);
+        return resizeBilinealConcurrente(info, etapa->ancho, etapa->alto, numHilos);
+    case ETAPA_VOLTEO_H:
+        return voltearHorizontal(info, numHilos);
+    default: // ETAPA_GRISES: no tiene función propia
+        return procesarEnMemoria(info, etapa, 1, 0, numHilos);
+    }
+}
+
+static int aplicarBarrera(ImagenInfo *info, const NodoGrafo *nodo, int numHilos)
+{
+    switch (nodo->tipo)
+    {
+    case NODO_VOLTEO_V:
+        return voltearVertical(info);
+    case NODO_TRANSPONER:
+        return transponerEnSitio(info, numHilos);
+    case NODO_DESENFOQUE:
+        return aplicarConvolucionConcurrente(info, nodo->tamKernel, nodo->sigma, numHilos);
+    default: // NODO_ROTAR
+    {
+        // En grises el fondo es el promedio del color, como el gris de Sobel
+        unsigned char gris = (unsigned char)((nodo->fondo[0] + nodo->fondo[1] + nodo->fondo[2]) / 3);
+        return rotarImagenConFondo(info, nodo->angulo, info->canales == 1 ? &gris : nodo->fondo, numHilos);
+    }
+    }
+}
+
+int grafoEjecutar(const GrafoOperaciones *grafo, ImagenInfo *info, int numHilos)
+{
+    if (!info->pixeles)
+    {
+        fprintf(stderr, "No hay imagen cargada.\n");
+        return 0;
+    }
+    EtapaFranjas *etapas = (EtapaFranjas *)malloc((size_t)(grafo->numNodos > 0 ? grafo->numNodos : 1) *
+                                                  sizeof(EtapaFranjas));
+    if (!etapas)
+    {
+        fprintf(stderr, "Error de memoria al planificar el grafo\n");
+        return 0;
+    }
+
+    int ok = 1;
+    int pasadas = 0;
+    for (int i = 0; ok && i < grafo->numNodos;)
+    {
+        int numEtapas;
+        planificarTramo(grafo, &i, etapas, &numEtapas);
+        if (numEtapas == 1 && !etapas[0].fundirLut)
+            ok = aplicarEtapa(info, &etapas[0], numHilos);
+        else if (numEtapas > 0)
+            ok = procesarEnMemoria(info, etapas, numEtapas, 0, numHilos);
+        pasadas += numEtapas > 0;
+
+        if (ok && i < grafo->numNodos)
+        {
+            ok = aplicarBarrera(info, &grafo->nodos[i++], numHilos);
+            pasadas++;
+        }
+    }
+    free(etapas);
+
+    if (ok)
+        IMG_INFO("Grafo ejecutado: %d operaciones en %d pasadas.\n", grafo->numNodos, pasadas);
+    return ok;
+}
+
+int grafoAdmiteFranjas(const GrafoOperaciones *grafo)
+{
+    for (int i = 0; i < grafo->numNodos; i++)
+    {
+        if (esBarrera(&grafo->nodos[i]))
+            return 0;
+    }
+    return 1;
+}
+
+int grafoProcesarPorFranjas(const GrafoOperaciones *grafo, FuenteFranjas *fuente, const char *rutaSalida,
+                            int numHilos)
+{
+    EtapaFranjas *etapas = (EtapaFranjas *)malloc((size_t)(grafo->numNodos > 0 ? grafo->numNodos : 1) *
+                                                  sizeof(EtapaFranjas));
+    if (!etapas)
+    {
+        fprintf(stderr, "Error de memoria al planificar el grafo\n");
+        return 0;
+    }
+    int i = 0, numEtapas;
+    planificarTramo(grafo, &i, etapas, &numEtapas);
+    int ok = i == grafo->numNodos;
+    if (!ok)
+        fprintf(stderr, "El procesamiento por franjas no admite rotación, transposición, volteo vertical ni "
+                        "desenfoque recursivo\n");
+    else
+        ok = procesarPorFranjas(fuente, etapas, numEtapas, rutaSalida, 0, numHilos);
+    free(etapas);
+    return ok;
+}
@@ -0,0 +1,60 @@
+#ifndef GRAFO_H
+#define GRAFO_H
+
+#include "imagen_info.h"
+#include "point.h"
+#include "stream.h"
+
+// Grafo de operaciones con evaluación perezosa. Las funciones grafo* solo
+// encolan la operación; grafoEjecutar planifica la cadena completa y la
+// aplica. El planificador funde lo que se puede calcular fila a fila:
+//   - las operaciones puntuales seguidas se componen en una sola tabla, y
+//     esa tabla se aplica al copiar las filas de entrada de la operación
+//     siguiente (desenfoque, kernel, Sobel, redimensionado...);
+//   - la conversión a grises justo antes de Sobel desaparece (Sobel ya
+//     calcula el mismo gris al leer cada fila);
+//   - cada tramo entre operaciones que necesitan la imagen entera (rotación,
+//     transposición, volteo vertical, desenfoque recursivo) se ejecuta por
+//     franjas del tamaño de la caché en el pool (ver procesarEnMemoria), sin
+//     imágenes intermedias completas.
+// El resultado es el mismo que aplicar las operaciones una a una.
+
+typedef struct GrafoOperaciones GrafoOperaciones;
+
+// Devuelve NULL si no hay memoria
+GrafoOperaciones *grafoCrear(void);
+void grafoLiberar(GrafoOperaciones *grafo);
+
+// Número de operaciones encoladas
+int grafoNumOperaciones(const GrafoOperaciones *grafo);
+
+// Encolar operaciones (no tocan ninguna imagen). Devuelven 0 si no hay
+// memoria o los parámetros no son válidos.
+int grafoBrillo(GrafoOperaciones *grafo, int delta);
+int grafoLut(GrafoOperaciones *grafo, const LutPuntual *lut);
+int grafoGrises(GrafoOperaciones *grafo);
+int grafoDesenfoque(GrafoOperaciones *grafo, int tamKernel, float sigma);
+int grafoKernel(GrafoOperaciones *grafo, const float *pesos, int tam);
+int grafoSobel(GrafoOperaciones *grafo);
+int grafoResize(GrafoOperaciones *grafo, int ancho, int alto, int filtro); // filtro -1 = bilineal
+int grafoVoltear(GrafoOperaciones *grafo, char eje);                       // 'h' o 'v'
+int grafoRotar(GrafoOperaciones *grafo, float angulo, const unsigned char fondo[3]);
+int grafoTransponer(GrafoOperaciones *grafo);
+
+// Aplica todas las operaciones a info (que se reemplaza por el resultado).
+// El grafo no cambia y se puede ejecutar sobre otras imágenes. numHilos <= 0
+// usa el número de hilos por defecto del pool. Devuelve 1 si se aplicó.
+int grafoEjecutar(const GrafoOperaciones *grafo, ImagenInfo *info, int numHilos);
+
+// Devuelve 1 si todas las operaciones se pueden aplicar por franjas
+int grafoAdmiteFranjas(const GrafoOperaciones *grafo);
+
+// Aplica el grafo por franjas desde la fuente y guarda el PNG en rutaSalida
+// (ver procesarPorFranjas). Solo admite operaciones fila a fila: falla con
+// rotación, transposición, volteo vertical o un desenfoque que usaría el
+// filtro recursivo (ver desenfoqueUsaRecursivo), así que el resultado es
+// siempre el mismo que con grafoEjecutar.
+int grafoProcesarPorFranjas(const GrafoOperaciones *grafo, FuenteFranjas *fuente, const char *rutaSalida,
+                            int numHilos);
+
+#endif // GRAFO_H
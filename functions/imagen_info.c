@@ -0,0 +1,111 @@
+#include "imagen_info.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int imagenModoSilencioso = 0;
+
+int imagenTamanoValido(int ancho, int alto, int canales, size_t *bytes)
+{
+    if (ancho <= 0 || alto <= 0 || canales < 1 || canales > 4)
+        return 0;
+    const size_t bytesFila = (size_t)ancho * (size_t)canales;
+    if (bytesFila > IMAGEN_BYTES_FILA_MAXIMO)
+        return 0;
+    // Píxeles y punteros a filas tienen que caber en size_t
+    if (bytesFila > SIZE_MAX / (size_t)alto || (size_t)alto > SIZE_MAX / sizeof(unsigned char *))
+        return 0;
+    if (bytes)
+        *bytes = bytesFila * (size_t)alto;
+    return 1;
+}
+
+int crearImagen(ImagenInfo *info, int ancho, int alto, int canales)
+{
+    if (!imagenTamanoValido(ancho, alto, canales, NULL))
+    {
+        fprintf(stderr, "Tamaño de imagen inválido: %dx%d, %d canales\n", ancho, alto, canales);
+        info->datos = NULL;
+        info->pixeles = NULL;
+        info->liberarDatos = NULL;
+        liberarImagen(info);
+        return 0;
+    }
+
+    info->ancho = ancho;
+    info->alto = alto;
+    info->canales = canales;
+    info->paso = (size_t)ancho * (size_t)canales;
+    info->liberarDatos = NULL;
+
+    // Un solo bloque para todos los píxeles y otro para los punteros a filas
+    info->datos = (unsigned char *)calloc((size_t)alto, info->paso);
+    info->pixeles = (unsigned char **)malloc((size_t)alto * sizeof(unsigned char *));
+    if (!info->datos || !info->pixeles)
+    {
+        fprintf(stderr, "Error de memoria al asignar imagen %dx%d\n", ancho, alto);
+        liberarImagen(info);
+        return 0;
+    }
+
+    for (int y = 0; y < alto; y++)
+    {
+        info->pixeles[y] = info->datos + (size_t)y * info->paso;
+    }
+    return 1;
+}
+
+int adoptarBuffer(ImagenInfo *info, unsigned char *datos, int ancho, int alto, int canales,
+                  void (*liberarDatos)(void *))
+{
+    if (!imagenTamanoValido(ancho, alto, canales, NULL))
+    {
+        fprintf(stderr, "Tamaño de imagen inválido: %dx%d, %d canales\n", ancho, alto, canales);
+        return 0;
+    }
+
+    // Solo hace falta reservar los punteros a filas
+    unsigned char **filas = (unsigned char **)malloc((size_t)alto * sizeof(unsigned char *));
+    if (!filas)
+    {
+        fprintf(stderr, "Error de memoria al asignar filas\n");
+        return 0;
+    }
+
+    info->ancho = ancho;
+    info->alto = alto;
+    info->canales = canales;
+    info->paso = (size_t)ancho * (size_t)canales;
+    info->datos = datos;
+    info->pixeles = filas;
+    info->liberarDatos = liberarDatos;
+    for (int y = 0; y < alto; y++)
+    {
+        info->pixeles[y] = info->datos + (size_t)y * info->paso;
+    }
+    return 1;
+}
+
+void liberarImagen(ImagenInfo *info)
+{
+    free(info->pixeles);
+    if (info->liberarDatos && info->datos)
+        info->liberarDatos(info->datos);
+    else
+        free(info->datos);
+    info->pixeles = NULL;
+    info->liberarDatos = NULL;
+    info->datos = NULL;
+    info->paso = 0;
+    info->ancho = 0;
+    info->alto = 0;
+    info->canales = 0;
+}
+
+void reemplazarImagen(ImagenInfo *info, ImagenInfo *nueva)
+{
+    liberarImagen(info);
+    *info = *nueva;
+    nueva->datos = NULL;
+    nueva->pixeles = NULL;
+}
@@ -1,13 +1,62 @@
 #ifndef IMAGEN_INFO_H
 #define IMAGEN_INFO_H
 
+#include <stddef.h>
 
+// La imagen vive en un único buffer contiguo (datos) de `alto` filas de `paso`
+// bytes. pixeles guarda un puntero por fila dentro de ese buffer, de modo que
+// el canal c del píxel (x, y) es pixeles[y][x * canales + c].
 typedef struct
 {
-    int ancho;                
-    int alto;                
-    int canales;              
-    unsigned char ***pixeles;
+    int ancho;
+    int alto;
+    int canales;
+    size_t paso;             // bytes por fila (stride)
+    unsigned char *datos;    // buffer contiguo de alto * paso bytes
+    unsigned char **pixeles; // punteros a filas dentro de datos
+    void (*liberarDatos)(void *); // libera datos; NULL = free()
 } ImagenInfo;
 
-#endif // IMAGEN_INFO_H
\ No newline at end of file
+// Si es distinto de 0, las operaciones no imprimen mensajes informativos
+// (modo lote). Los errores siempre van a stderr.
+extern int imagenModoSilencioso;
+
+// printf para mensajes informativos que respeta imagenModoSilencioso
+#define IMG_INFO(...)                  \
+    do                                 \
+    {                                  \
+        if (!imagenModoSilencioso)     \
+            printf(__VA_ARGS__);       \
+    } while (0)
+
+// Acceso al primer canal del píxel (x, y)
+#define IMG_PIXEL(info, y, x) ((info)->pixeles[(y)] + (size_t)(x) * (size_t)(info)->canales)
+
+// Tamaños: ancho y alto son int, pero todo desplazamiento entre filas o
+// total de bytes se calcula en size_t. Dentro de una fila se admiten
+// índices int (tablas del redimensionado, núcleos SIMD), por eso una fila no
+// puede pasar de IMAGEN_BYTES_FILA_MAXIMO bytes.
+#define IMAGEN_BYTES_FILA_MAXIMO 0x7FFFFFFF
+
+// Comprueba ancho, alto y canales (1 a 4) y que la fila y la imagen quepan;
+// si bytes no es NULL devuelve ahí alto * ancho * canales. Devuelve 0 si el
+// tamaño no es válido o desborda.
+int imagenTamanoValido(int ancho, int alto, int canales, size_t *bytes);
+
+// Reserva una imagen en negro con buffer contiguo y punteros a filas.
+// Devuelve 1 si todo fue bien, 0 si no hubo memoria (info queda vacía).
+int crearImagen(ImagenInfo *info, int ancho, int alto, int canales);
+
+// Construye la imagen sobre un buffer ya existente de alto * ancho * canales
+// bytes sin copiarlo: la imagen pasa a ser dueña de datos y lo libera con
+// liberarDatos (NULL = free) en liberarImagen. Si falla, datos no se libera.
+int adoptarBuffer(ImagenInfo *info, unsigned char *datos, int ancho, int alto, int canales,
+                  void (*liberarDatos)(void *));
+
+// Libera el buffer y los punteros a filas, y reinicia la estructura.
+void liberarImagen(ImagenInfo *info);
+
+// Libera la imagen actual de info y la sustituye por nueva (mueve punteros).
+void reemplazarImagen(ImagenInfo *info, ImagenInfo *nueva);
+
+#endif // IMAGEN_INFO_H
@@ -0,0 +1,678 @@
+// Escritor PNG por tramos: filtrado por fila + deflate (LZ77 con Huffman fijo)
+
+#include "png_writer.h"
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VENTANA_DEFLATE 32768     // distancia máxima de deflate
+#define BITS_HASH 15
+#define TAM_HASH (1 << BITS_HASH)
+#define MAX_CADENA 16             // candidatos revisados por posición
+#define LARGO_MIN 3
+#define LARGO_MAX 258
+#define BYTES_POR_SEGMENTO (256 * 1024) // datos de cada segmento deflate independiente
+#define SEGMENTOS_POR_HILO 4             // segmentos por hilo en cada tramo de guardarPNGFilas
+
+struct EscritorPNG
+{
+    FuncionEscrituraPNG escribir;
+    void *ctx;
+    int ancho;
+    int alto;
+    int canales;
+    size_t bytesFila;
+    int filasEscritas;
+    unsigned char *filaPrevia; // última fila escrita (referencia de los filtros)
+    unsigned char *ventana;    // últimos datos filtrados, diccionario del siguiente tramo
+    size_t largoVentana;
+    unsigned long adler;
+    int error;
+};
+
+// ---------- CRC-32 (chunks) y Adler-32 (zlib) ----------
+
+static unsigned int tablaCrc[256];
+
+static void iniciarTablaCrc(void)
+{
+    for (unsigned int n = 0; n < 256; n++)
+    {
+        unsigned int c = n;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        tablaCrc[n] = c;
+    }
+}
+
+static unsigned int crc32Actualizar(unsigned int crc, const unsigned char *datos, size_t largo)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < largo; i++)
+        crc = tablaCrc[(crc ^ datos[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+#define ADLER_MOD 65521u
+
+static unsigned long adler32Actualizar(unsigned long adler, const unsigned char *datos, size_t largo)
+{
+    unsigned long a = adler & 0xFFFF, b = (adler >> 16) & 0xFFFF;
+    while (largo > 0)
+    {
+        // 5552 es el máximo de bytes sin desbordar antes de reducir módulo
+        size_t n = largo < 5552 ? largo : 5552;
+        largo -= n;
+        while (n--)
+        {
+            a += *datos++;
+            b += a;
+        }
+        a %= ADLER_MOD;
+        b %= ADLER_MOD;
+    }
+    return (b << 16) | a;
+}
+
+// ---------- Salida de bits (deflate escribe el bit menos significativo primero) ----------
+
+typedef struct
+{
+    unsigned char *datos;
+    size_t largo;
+    size_t capacidad;
+    unsigned int bits;
+    int numBits;
+    int error;
+} SalidaBits;
+
+static void bitsAsegurar(SalidaBits *s, size_t extra)
+{
+    if (s->largo + extra <= s->capacidad)
+        return;
+    size_t nueva = s->capacidad ? s->capacidad * 2 : 4096;
+    while (nueva < s->largo + extra)
+        nueva *= 2;
+    unsigned char *datos = (unsigned char *)realloc(s->datos, nueva);
+    if (!datos)
+    {
+        s->error = 1;
+        return;
+    }
+    s->datos = datos;
+    s->capacidad = nueva;
+}
+
+static inline void bitsEscribir(SalidaBits *s, unsigned int valor, int n)
+{
+    s->bits |= valor << s->numBits;
+    s->numBits += n;
+    while (s->numBits >= 8)
+    {
+        if (s->largo == s->capacidad)
+        {
+            bitsAsegurar(s, 1);
+            if (s->error)
+                return;
+        }
+        s->datos[s->largo++] = (unsigned char)s->bits;
+        s->bits >>= 8;
+        s->numBits -= 8;
+    }
+}
+
+// ---------- Códigos Huffman fijos de deflate ----------
+
+static unsigned short codigoLiteral[288]; // código ya invertido (LSB primero)
+static unsigned char bitsLiteral[288];
+static pthread_once_t tablasIniciadas = PTHREAD_ONCE_INIT;
+
+static const unsigned short baseLargo[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+                                           31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258, 259};
+static const unsigned char extraLargo[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                           2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const unsigned short baseDist[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                          257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                          8193, 12289, 16385, 24577, 32769};
+static const unsigned char extraDist[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                          7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static unsigned int invertirBits(unsigned int codigo, int n)
+{
+    unsigned int r = 0;
+    for (int i = 0; i < n; i++)
+    {
+        r = (r << 1) | (codigo & 1);
+        codigo >>= 1;
+    }
+    return r;
+}
+
+static void iniciarTablas(void)
+{
+    for (int v = 0; v < 288; v++)
+    {
+        unsigned int codigo;
+        int n;
+        if (v <= 143)
+            codigo = 0x30 + v, n = 8;
+        else if (v <= 255)
+            codigo = 0x190 + (v - 144), n = 9;
+        else if (v <= 279)
+            codigo = v - 256, n = 7;
+        else
+            codigo = 0xC0 + (v - 280), n = 8;
+        codigoLiteral[v] = (unsigned short)invertirBits(codigo, n);
+        bitsLiteral[v] = (unsigned char)n;
+    }
+    iniciarTablaCrc();
+}
+
+static inline void escribirSimbolo(SalidaBits *s, int v)
+{
+    bitsEscribir(s, codigoLiteral[v], bitsLiteral[v]);
+}
+
+static void escribirCoincidencia(SalidaBits *s, int largo, int distancia)
+{
+    int j = 0;
+    while (baseLargo[j + 1] <= largo)
+        j++;
+    escribirSimbolo(s, 257 + j);
+    if (extraLargo[j])
+        bitsEscribir(s, (unsigned int)(largo - baseLargo[j]), extraLargo[j]);
+
+    j = 0;
+    while (baseDist[j + 1] <= distancia)
+        j++;
+    bitsEscribir(s, invertirBits((unsigned int)j, 5), 5);
+    if (extraDist[j])
+        bitsEscribir(s, (unsigned int)(distancia - baseDist[j]), extraDist[j]);
+}
+
+// ---------- LZ77 ----------
+
+static inline unsigned int hash3(const unsigned char *p)
+{
+    unsigned int v = ((unsigned int)p[0] << 16) | ((unsigned int)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - BITS_HASH);
+}
+
+typedef struct
+{
+    int *cabeza;  // última posición vista por hash (-1 = ninguna)
+    int *anterior; // posición previa con el mismo hash, indexada por pos % ventana
+} TablaLZ;
+
+static inline void lzInsertar(TablaLZ *t, const unsigned char *base, int pos)
+{
+    unsigned int h = hash3(base + pos);
+    t->anterior[pos & (VENTANA_DEFLATE - 1)] = t->cabeza[h];
+    t->cabeza[h] = pos;
+}
+
+// Mejor coincidencia para la posición pos; devuelve su largo (0 si < 3)
+static int lzBuscar(const TablaLZ *t, const unsigned char *base, int pos, int fin, int *distancia)
+{
+    int maxLargo = fin - pos < LARGO_MAX ? fin - pos : LARGO_MAX;
+    if (maxLargo < LARGO_MIN)
+        return 0;
+
+    int mejor = 0;
+    int cand = t->cabeza[hash3(base + pos)];
+    int limite = pos - VENTANA_DEFLATE;
+    for (int i = 0; i < MAX_CADENA && cand >= 0 && cand > limite && cand < pos; i++)
+    {
+        const unsigned char *a = base + cand, *b = base + pos;
+        if (a[mejor] == b[mejor])
+        {
+            int n = 0;
+            while (n < maxLargo && a[n] == b[n])
+                n++;
+            if (n > mejor)
+            {
+                mejor = n;
+                *distancia = pos - cand;
+                if (n == maxLargo)
+                    break;
+            }
+        }
+        int siguiente = t->anterior[cand & (VENTANA_DEFLATE - 1)];
+        if (siguiente >= cand)
+            break; // la entrada fue sobrescrita por una posición más nueva
+        cand = siguiente;
+    }
+    return mejor >= LARGO_MIN ? mejor : 0;
+}
+
+// Comprime base[inicio, fin) como un bloque deflate con Huffman fijo no final,
+// usando base[inicio - 32 KiB, inicio) como diccionario, y termina con un
+// vaciado de sincronización (bloque stored vacío) para quedar alineado a byte.
+// La salida se añade a s.
+static void deflateSegmento(SalidaBits *s, const unsigned char *base, size_t inicio, size_t fin)
+{
+    size_t desde = inicio > VENTANA_DEFLATE ? inicio - VENTANA_DEFLATE : 0;
+    const unsigned char *datos = base + desde;
+    int ini = (int)(inicio - desde);
+    int n = (int)(fin - desde);
+
+    TablaLZ t;
+    t.cabeza = (int *)malloc(TAM_HASH * sizeof(int));
+    t.anterior = (int *)malloc(VENTANA_DEFLATE * sizeof(int));
+    if (!t.cabeza || !t.anterior)
+    {
+        free(t.cabeza);
+        free(t.anterior);
+        s->error = 1;
+        return;
+    }
+    memset(t.cabeza, 0xFF, TAM_HASH * sizeof(int));
+
+    // Peor caso del Huffman fijo: 9 bits por byte, más cabeceras
+    bitsAsegurar(s, (size_t)(n - ini) * 9 / 8 + 64);
+    if (s->error)
+    {
+        free(t.cabeza);
+        free(t.anterior);
+        return;
+    }
+
+    for (int p = 0; p + LARGO_MIN <= ini; p++)
+        lzInsertar(&t, datos, p);
+
+    bitsEscribir(s, 0, 1); // BFINAL = 0
+    bitsEscribir(s, 1, 2); // BTYPE = 01 (Huffman fijo)
+
+    int i = ini;
+    while (i < n && !s->error)
+    {
+        int dist = 0, largo = 0;
+        if (i + LARGO_MIN <= n)
+        {
+            largo = lzBuscar(&t, datos, i, n, &dist);
+            lzInsertar(&t, datos, i);
+        }
+
+        // Evaluación perezosa: si la siguiente posición tiene una coincidencia
+        // más larga, emitir este byte como literal
+        if (largo && largo < LARGO_MAX && i + 1 + LARGO_MIN <= n)
+        {
+            int dist2 = 0;
+            int largo2 = lzBuscar(&t, datos, i + 1, n, &dist2);
+            if (largo2 > largo)
+                largo = 0;
+        }
+
+        if (largo)
+        {
+            escribirCoincidencia(s, largo, dist);
+            for (int k = 1; k < largo; k++)
+                if (i + k + LARGO_MIN <= n)
+                    lzInsertar(&t, datos, i + k);
+            i += largo;
+        }
+        else
+        {
+            escribirSimbolo(s, datos[i]);
+            i++;
+        }
+    }
+    escribirSimbolo(s, 256); // fin de bloque
+
+    // Vaciado de sincronización: bloque stored vacío, alineado a byte
+    bitsEscribir(s, 0, 3);
+    if (s->numBits > 0)
+        bitsEscribir(s, 0, 8 - s->numBits);
+    bitsEscribir(s, 0x0000, 16);
+    bitsEscribir(s, 0xFFFF, 16);
+
+    free(t.cabeza);
+    free(t.anterior);
+}
+
+// ---------- Filtros PNG ----------
+
+static inline int paeth(int a, int b, int c)
+{
+    int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    if (pb <= pc)
+        return b;
+    return c;
+}
+
+static void aplicarFiltro(int tipo, const unsigned char *z, const unsigned char *arriba, size_t n,
+                          int bpp, unsigned char *salida)
+{
+    size_t i;
+    switch (tipo)
+    {
+    case 0:
+        memcpy(salida, z, n);
+        break;
+    case 1:
+        for (i = 0; i < (size_t)bpp; i++)
+            salida[i] = z[i];
+        for (; i < n; i++)
+            salida[i] = (unsigned char)(z[i] - z[i - bpp]);
+        break;
+    case 2:
+        for (i = 0; i < n; i++)
+            salida[i] = (unsigned char)(z[i] - arriba[i]);
+        break;
+    case 3:
+        for (i = 0; i < (size_t)bpp; i++)
+            salida[i] = (unsigned char)(z[i] - (arriba[i] >> 1));
+        for (; i < n; i++)
+            salida[i] = (unsigned char)(z[i] - ((z[i - bpp] + arriba[i]) >> 1));
+        break;
+    case 4:
+        for (i = 0; i < (size_t)bpp; i++)
+            salida[i] = (unsigned char)(z[i] - arriba[i]);
+        for (; i < n; i++)
+            salida[i] = (unsigned char)(z[i] - paeth(z[i - bpp], arriba[i], arriba[i - bpp]));
+        break;
+    }
+}
+
+// Filtra una fila probando los 5 filtros y quedándose con el de menor suma
+// de valores absolutos (misma heurística que stb_image_write).
+// salida recibe 1 + n bytes: tipo de filtro y datos filtrados.
+// arriba es la fila anterior (ceros para la primera); tmp tiene n bytes.
+static void filtrarFila(const unsigned char *z, const unsigned char *arriba, size_t n, int bpp,
+                        unsigned char *salida, unsigned char *tmp)
+{
+    long mejorSuma = -1;
+    for (int tipo = 0; tipo < 5; tipo++)
+    {
+        aplicarFiltro(tipo, z, arriba, n, bpp, tmp);
+        long suma = 0;
+        for (size_t i = 0; i < n; i++)
+            suma += abs((signed char)tmp[i]);
+        if (mejorSuma < 0 || suma < mejorSuma)
+        {
+            mejorSuma = suma;
+            salida[0] = (unsigned char)tipo;
+            memcpy(salida + 1, tmp, n);
+        }
+    }
+}
+
+// ---------- Chunks ----------
+
+static void escribirU32(unsigned char *p, unsigned long v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static void escribirChunk(EscritorPNG *png, const char *tipo, const unsigned char *datos, size_t largo)
+{
+    unsigned char cabecera[8], cola[4];
+    escribirU32(cabecera, (unsigned long)largo);
+    memcpy(cabecera + 4, tipo, 4);
+    unsigned int crc = crc32Actualizar(0, cabecera + 4, 4);
+    crc = crc32Actualizar(crc, datos, largo);
+    escribirU32(cola, crc);
+
+    png->escribir(png->ctx, cabecera, 8);
+    if (largo)
+        png->escribir(png->ctx, datos, largo);
+    png->escribir(png->ctx, cola, 4);
+}
+
+// ---------- API ----------
+
+EscritorPNG *pngAbrir(FuncionEscrituraPNG escribir, void *ctx, int ancho, int alto, int canales)
+{
+    pthread_once(&tablasIniciadas, iniciarTablas);
+
+    if (ancho <= 0 || alto <= 0 || (canales != 1 && canales != 3))
+        return NULL;
+
+    EscritorPNG *png = (EscritorPNG *)calloc(1, sizeof(EscritorPNG));
+    if (!png)
+        return NULL;
+    png->escribir = escribir;
+    png->ctx = ctx;
+    png->ancho = ancho;
+    png->alto = alto;
+    png->canales = canales;
+    png->bytesFila = (size_t)ancho * canales;
+    png->adler = 1;
+    png->filaPrevia = (unsigned char *)calloc(png->bytesFila, 1); // ceros: fila "anterior" a la primera
+    if (!png->filaPrevia)
+    {
+        free(png);
+        return NULL;
+    }
+
+    static const unsigned char firma[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    unsigned char ihdr[13];
+    escribirU32(ihdr, (unsigned long)ancho);
+    escribirU32(ihdr + 4, (unsigned long)alto);
+    ihdr[8] = 8;                     // bits por canal
+    ihdr[9] = canales == 1 ? 0 : 2;  // grises o RGB
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;
+    escribir(ctx, firma, 8);
+    escribirChunk(png, "IHDR", ihdr, 13);
+
+    // Cabecera zlib (deflate, ventana de 32 KiB)
+    static const unsigned char cabeceraZlib[2] = {0x78, 0x5E};
+    escribirChunk(png, "IDAT", cabeceraZlib, 2);
+    return png;
+}
+
+// Filtrado en paralelo: cada fila solo depende de la original de arriba
+typedef struct
+{
+    unsigned char *const *filas;
+    const unsigned char *filaPrevia; // fila anterior a filas[0]
+    size_t bytesFila;
+    int canales;
+    unsigned char *filtrado;
+    int error;
+} FiltrarArgs;
+
+static void filtrarRango(void *ctx, int inicio, int fin)
+{
+    FiltrarArgs *args = (FiltrarArgs *)ctx;
+    unsigned char *tmp = (unsigned char *)malloc(args->bytesFila);
+    if (!tmp)
+    {
+        args->error = 1;
+        return;
+    }
+    for (int i = inicio; i < fin; i++)
+    {
+        const unsigned char *arriba = i == 0 ? args->filaPrevia : args->filas[i - 1];
+        filtrarFila(args->filas[i], arriba, args->bytesFila, args->canales,
+                    args->filtrado + (size_t)i * (args->bytesFila + 1), tmp);
+    }
+    free(tmp);
+}
+
+// Compresión en paralelo: segmentos independientes (cada uno con los 32 KiB
+// previos como diccionario y terminado en vaciado de sincronización), que
+// concatenados forman un único flujo deflate válido
+typedef struct
+{
+    const unsigned char *buffer;
+    size_t inicio; // primer byte nuevo dentro de buffer
+    size_t largo;  // bytes nuevos
+    int numSegmentos;
+    SalidaBits *salidas;
+    unsigned long *adlers;
+} DeflateArgs;
+
+static void deflateRango(void *ctx, int inicio, int fin)
+{
+    DeflateArgs *args = (DeflateArgs *)ctx;
+    for (int k = inicio; k < fin; k++)
+    {
+        size_t desde = args->inicio + args->largo * k / args->numSegmentos;
+        size_t hasta = args->inicio + args->largo * (k + 1) / args->numSegmentos;
+        args->adlers[k] = adler32Actualizar(1, args->buffer + desde, hasta - desde);
+        deflateSegmento(&args->salidas[k], args->buffer, desde, hasta);
+    }
+}
+
+// Adler-32 de la concatenación A + B a partir de los de A y B (largo de B)
+static unsigned long adler32Combinar(unsigned long adlerA, unsigned long adlerB, size_t largoB)
+{
+    unsigned long resto = (unsigned long)(largoB % ADLER_MOD);
+    unsigned long suma1 = adlerA & 0xFFFF;
+    unsigned long suma2 = (resto * suma1) % ADLER_MOD;
+    suma1 += (adlerB & 0xFFFF) + ADLER_MOD - 1;
+    suma2 += ((adlerA >> 16) & 0xFFFF) + ((adlerB >> 16) & 0xFFFF) + ADLER_MOD - resto;
+    if (suma1 >= ADLER_MOD)
+        suma1 -= ADLER_MOD;
+    if (suma1 >= ADLER_MOD)
+        suma1 -= ADLER_MOD;
+    if (suma2 >= (ADLER_MOD << 1))
+        suma2 -= (ADLER_MOD << 1);
+    if (suma2 >= ADLER_MOD)
+        suma2 -= ADLER_MOD;
+    return suma1 | (suma2 << 16);
+}
+
+int pngEscribirFilas(EscritorPNG *png, unsigned char *const *filas, int n)
+{
+    if (!png || png->error)
+        return 0;
+    if (n <= 0)
+        return 1;
+    if (png->filasEscritas + n > png->alto)
+    {
+        png->error = 1;
+        return 0;
+    }
+
+    // Buffer = diccionario (cola del tramo anterior) + filas filtradas nuevas
+    const size_t bytesFiltrada = png->bytesFila + 1;
+    const size_t largoNuevo = (size_t)n * bytesFiltrada;
+    unsigned char *buffer = (unsigned char *)malloc(png->largoVentana + largoNuevo);
+    if (!buffer)
+    {
+        png->error = 1;
+        return 0;
+    }
+    if (png->largoVentana)
+        memcpy(buffer, png->ventana, png->largoVentana);
+
+    // 1) Filtrar bloques de filas en el pool
+    FiltrarArgs filtrar = {filas, png->filaPrevia, png->bytesFila, png->canales,
+                           buffer + png->largoVentana, 0};
+    poolParaleloForTeselas(n, 0, poolFilasPorTesela(bytesFiltrada), filtrarRango, &filtrar);
+    memcpy(png->filaPrevia, filas[n - 1], png->bytesFila);
+
+    // 2) Comprimir segmentos independientes en el pool
+    int numSegmentos = (int)((largoNuevo + BYTES_POR_SEGMENTO - 1) / BYTES_POR_SEGMENTO);
+    SalidaBits *salidas = (SalidaBits *)calloc((size_t)numSegmentos, sizeof(SalidaBits));
+    unsigned long *adlers = (unsigned long *)malloc((size_t)numSegmentos * sizeof(unsigned long));
+    int ok = !filtrar.error && salidas && adlers;
+    if (ok)
+    {
+        DeflateArgs deflate = {buffer, png->largoVentana, largoNuevo, numSegmentos, salidas, adlers};
+        poolParaleloForTeselas(numSegmentos, 0, 1, deflateRango, &deflate);
+    }
+
+    // 3) Escribir en orden y combinar los Adler-32 de los segmentos
+    for (int k = 0; ok && k < numSegmentos; k++)
+    {
+        size_t desde = largoNuevo * k / numSegmentos;
+        size_t hasta = largoNuevo * (k + 1) / numSegmentos;
+        if (salidas[k].error)
+        {
+            ok = 0;
+            break;
+        }
+        escribirChunk(png, "IDAT", salidas[k].datos, salidas[k].largo);
+        png->adler = adler32Combinar(png->adler, adlers[k], hasta - desde);
+    }
+    for (int k = 0; salidas && k < numSegmentos; k++)
+        free(salidas[k].datos);
+    free(salidas);
+    free(adlers);
+
+    // Guardar los últimos 32 KiB como diccionario del siguiente tramo
+    size_t total = png->largoVentana + largoNuevo;
+    size_t largoVentana = total < VENTANA_DEFLATE ? total : VENTANA_DEFLATE;
+    unsigned char *ventana = ok ? (unsigned char *)realloc(png->ventana, largoVentana) : NULL;
+    if (!ventana)
+    {
+        free(buffer);
+        png->error = 1;
+        return 0;
+    }
+    memcpy(ventana, buffer + total - largoVentana, largoVentana);
+    png->ventana = ventana;
+    png->largoVentana = largoVentana;
+    free(buffer);
+
+    png->filasEscritas += n;
+    return 1;
+}
+
+int pngCerrar(EscritorPNG *png)
+{
+    if (!png)
+        return 0;
+    int ok = !png->error && png->filasEscritas == png->alto;
+
+    if (ok)
+    {
+        // Bloque final vacío (BFINAL = 1, Huffman fijo, fin de bloque) + Adler-32
+        unsigned char cola[6] = {0x03, 0x00};
+        escribirU32(cola + 2, png->adler);
+        escribirChunk(png, "IDAT", cola, 6);
+        escribirChunk(png, "IEND", NULL, 0);
+    }
+
+    free(png->filaPrevia);
+    free(png->ventana);
+    free(png);
+    return ok;
+}
+
+static void escribirArchivo(void *ctx, const void *datos, size_t largo)
+{
+    fwrite(datos, 1, largo, (FILE *)ctx);
+}
+
+int guardarPNGFilas(const char *ruta, unsigned char *const *filas, int ancho, int alto, int canales)
+{
+    FILE *f = fopen(ruta, "wb");
+    if (!f)
+        return 0;
+
+    EscritorPNG *png = pngAbrir(escribirArchivo, f, ancho, alto, canales);
+    if (!png)
+    {
+        fclose(f);
+        return 0;
+    }
+
+    // Tramos con unos pocos segmentos por hilo: trabajo para todo el pool y
+    // memoria acotada sin importar el tamaño de la imagen
+    size_t bytesFila = (size_t)ancho * canales + 1;
+    size_t bytesTramo = (size_t)BYTES_POR_SEGMENTO * SEGMENTOS_POR_HILO * poolNumHilos();
+    int filasPorTramo = (int)(bytesTramo / bytesFila);
+    if (filasPorTramo < 1)
+        filasPorTramo = 1;
+    for (int y = 0; y < alto; y += filasPorTramo)
+    {
+        int n = alto - y < filasPorTramo ? alto - y : filasPorTramo;
+        if (!pngEscribirFilas(png, filas + y, n))
+            break;
+    }
+
+    int ok = pngCerrar(png);
+    if (fclose(f) != 0)
+        ok = 0;
+    return ok;
+}
@@ -0,0 +1,33 @@
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Escritor PNG por tramos de filas. Recibe punteros a filas (no necesita que
+// la imagen sea contigua) y va emitiendo chunks IDAT a medida que comprime,
+// así que nunca reserva una copia completa de la imagen. Cada tramo se filtra
+// por bloques de filas y se comprime en segmentos deflate independientes en
+// el pool de hilos (al estilo de pigz); el resultado es un único PNG estándar.
+
+// Función que recibe los bytes del archivo PNG (misma idea que stbi_write_func)
+typedef void (*FuncionEscrituraPNG)(void *ctx, const void *datos, size_t largo);
+
+typedef struct EscritorPNG EscritorPNG;
+
+// Crea el escritor y emite la firma y la cabecera IHDR.
+// canales: 1 (grises) o 3 (RGB). Devuelve NULL si no hay memoria.
+EscritorPNG *pngAbrir(FuncionEscrituraPNG escribir, void *ctx, int ancho, int alto, int canales);
+
+// Filtra y comprime n filas consecutivas (en orden, de arriba hacia abajo).
+// Usa el pool de hilos. Devuelve 1 si todo fue bien.
+int pngEscribirFilas(EscritorPNG *png, unsigned char *const *filas, int n);
+
+// Cierra el flujo deflate, emite IEND y libera el escritor.
+// Devuelve 1 si todas las filas se escribieron correctamente.
+int pngCerrar(EscritorPNG *png);
+
+// Guarda en ruta una imagen dada por sus punteros a filas.
+int guardarPNGFilas(const char *ruta, unsigned char *const *filas, int ancho, int alto, int canales);
+
+#endif // PNG_WRITER_H
@@ -0,0 +1,165 @@
+// Operaciones puntuales con tablas de consulta
+
+#include "point.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static unsigned char limitarByte(double v)
+{
+    if (v <= 0.0)
+        return 0;
+    if (v >= 255.0)
+        return 255;
+    return (unsigned char)(v + 0.5);
+}
+
+void lutIdentidad(LutPuntual *lut)
+{
+    for (int c = 0; c < LUT_MAX_CANALES; c++)
+        for (int v = 0; v < 256; v++)
+            lut->tabla[c][v] = (unsigned char)v;
+    memset(lut->relleno, 0, sizeof(lut->relleno));
+}
+
+void lutComponer(LutPuntual *lut, int canal, const unsigned char f[256])
+{
+    for (int c = 0; c < LUT_MAX_CANALES; c++)
+    {
+        if (canal >= 0 && c != canal)
+            continue;
+        for (int v = 0; v < 256; v++)
+            lut->tabla[c][v] = f[lut->tabla[c][v]];
+    }
+}
+
+void lutBrillo(LutPuntual *lut, int delta)
+{
+    unsigned char f[256];
+    for (int v = 0; v < 256; v++)
+    {
+        int nuevo = v + delta;
+        f[v] = (unsigned char)(nuevo < 0 ? 0 : (nuevo > 255 ? 255 : nuevo));
+    }
+    lutComponer(lut, -1, f);
+}
+
+void lutContraste(LutPuntual *lut, float factor)
+{
+    unsigned char f[256];
+    for (int v = 0; v < 256; v++)
+        f[v] = limitarByte((v - 128) * (double)factor + 128.0);
+    lutComponer(lut, -1, f);
+}
+
+void lutGamma(LutPuntual *lut, float gamma)
+{
+    unsigned char f[256];
+    for (int v = 0; v < 256; v++)
+        f[v] = limitarByte(255.0 * pow(v / 255.0, 1.0 / gamma));
+    lutComponer(lut, -1, f);
+}
+
+int lutNiveles(LutPuntual *lut, int negro, int blanco, float gamma)
+{
+    if (negro < 0 || blanco > 255 || negro >= blanco || !(gamma > 0.0f))
+        return 0;
+    unsigned char f[256];
+    for (int v = 0; v < 256; v++)
+    {
+        int recortado = v < negro ? negro : (v > blanco ? blanco : v);
+        f[v] = limitarByte(255.0 * pow((double)(recortado - negro) / (blanco - negro), 1.0 / gamma));
+    }
+    lutComponer(lut, -1, f);
+    return 1;
+}
+
+void lutInvertir(LutPuntual *lut)
+{
+    unsigned char f[256];
+    for (int v = 0; v < 256; v++)
+        f[v] = (unsigned char)(255 - v);
+    lutComponer(lut, -1, f);
+}
+
+void lutUmbral(LutPuntual *lut, int umbral)
+{
+    unsigned char f[256];
+    for (int v = 0; v < 256; v++)
+        f[v] = v >= umbral ? 255 : 0;
+    lutComponer(lut, -1, f);
+}
+
+int lutCurva(LutPuntual *lut, int canal, const int *xs, const int *ys, int n)
+{
+    if (n < 1 || canal >= LUT_MAX_CANALES)
+        return 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (xs[i] < 0 || xs[i] > 255 || ys[i] < 0 || ys[i] > 255 || (i > 0 && xs[i] <= xs[i - 1]))
+            return 0;
+    }
+
+    unsigned char f[256];
+    int tramo = 0;
+    for (int v = 0; v < 256; v++)
+    {
+        if (v <= xs[0])
+            f[v] = (unsigned char)ys[0];
+        else if (v >= xs[n - 1])
+            f[v] = (unsigned char)ys[n - 1];
+        else
+        {
+            while (xs[tramo + 1] < v)
+                tramo++;
+            double t = (double)(v - xs[tramo]) / (xs[tramo + 1] - xs[tramo]);
+            f[v] = limitarByte(ys[tramo] + t * (ys[tramo + 1] - ys[tramo]));
+        }
+    }
+    lutComponer(lut, canal, f);
+    return 1;
+}
+
+void *aplicarLutHilo(void *args)
+{
+    LutArgs *l = (LutArgs *)args;
+    const NucleosSimd *simd = nucleosSimd();
+    const size_t n = (size_t)l->ancho * l->canales;
+    // Cada fila empieza en el canal 0, así que la misma tabla sirve para todas
+    for (int y = l->inicio; y < l->fin; y++)
+        simd->lutFila(l->pixeles[y], n, l->tabla, l->canales);
+    return NULL;
+}
+
+// Adaptador para el pool: ejecuta aplicarLutHilo sobre [inicio, fin)
+static void aplicarLutRango(void *ctx, int inicio, int fin)
+{
+    LutArgs args = *(LutArgs *)ctx;
+    args.inicio = inicio;
+    args.fin = fin;
+    aplicarLutHilo(&args);
+}
+
+int aplicarLutConcurrente(ImagenInfo *info, const LutPuntual *lut, int numHilos)
+{
+    if (!info->pixeles)
+    {
+        fprintf(stderr, "No hay imagen cargada.\n");
+        return 0;
+    }
+    if (info->canales > LUT_MAX_CANALES)
+    {
+        fprintf(stderr, "Tabla de consulta: se admiten hasta %d canales.\n", LUT_MAX_CANALES);
+        return 0;
+    }
+
+    numHilos = poolResolverHilos(numHilos);
+    // Las tablas de los canales son contiguas en LutPuntual: tabla[c * 256 + v]
+    LutArgs args = {info->pixeles, 0, 0, info->ancho, info->canales, &lut->tabla[0][0]};
+    poolParaleloForTeselas(info->alto, numHilos, poolFilasPorTesela(info->paso), aplicarLutRango, &args);
+    IMG_INFO("Tabla de consulta aplicada con %d hilos (%s).\n", numHilos,
+             info->canales == 1 ? "grises" : "RGB");
+    return 1;
+}
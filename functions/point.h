@@ -0,0 +1,68 @@
+#ifndef POINT_H
+#define POINT_H
+
+#include "imagen_info.h"
+
+// Operaciones puntuales (el valor de salida solo depende del valor de
+// entrada del mismo canal) compiladas en una tabla de 256 entradas por
+// canal. Cada lut* compone su función sobre la tabla actual, así una cadena
+// de N ajustes se aplica a la imagen en una sola pasada.
+
+#define LUT_MAX_CANALES 4
+
+typedef struct
+{
+    // tabla[c][v] = salida del canal c para el valor v. Los 4 bytes de
+    // relleno permiten a los núcleos SIMD leer 4 bytes por entrada.
+    unsigned char tabla[LUT_MAX_CANALES][256];
+    unsigned char relleno[4];
+} LutPuntual;
+
+typedef struct
+{
+    unsigned char **pixeles;
+    int inicio;
+    int fin;
+    int ancho;
+    int canales;
+    const unsigned char *tabla; // canales * 256 bytes (+ relleno)
+} LutArgs;
+
+// Tabla identidad (no cambia nada)
+void lutIdentidad(LutPuntual *lut);
+
+// Compone f después de la tabla actual en el canal dado (-1 = todos)
+void lutComponer(LutPuntual *lut, int canal, const unsigned char f[256]);
+
+// v + delta con saturación, igual que ajustarBrilloConcurrente
+void lutBrillo(LutPuntual *lut, int delta);
+
+// (v - 128) * factor + 128; factor > 1 aumenta el contraste
+void lutContraste(LutPuntual *lut, float factor);
+
+// 255 * (v / 255)^(1 / gamma); gamma > 1 aclara los medios tonos
+void lutGamma(LutPuntual *lut, float gamma);
+
+// Lleva [negro, blanco] a [0, 255] (fuera se satura) con gamma de medios
+// tonos. Devuelve 0 si los parámetros no son válidos.
+int lutNiveles(LutPuntual *lut, int negro, int blanco, float gamma);
+
+// 255 - v
+void lutInvertir(LutPuntual *lut);
+
+// 255 si v >= umbral, 0 si no
+void lutUmbral(LutPuntual *lut, int umbral);
+
+// Curva lineal a trozos por los puntos (xs[i], ys[i]), con xs creciente, en
+// el canal dado (-1 = todos); fuera de los extremos es constante.
+// Devuelve 0 si los puntos no son válidos.
+int lutCurva(LutPuntual *lut, int canal, const int *xs, const int *ys, int n);
+
+// Aplica la tabla a las filas [inicio, fin)
+void *aplicarLutHilo(void *args);
+
+// Aplica la tabla a toda la imagen en una pasada. numHilos <= 0 usa el
+// número de hilos por defecto del pool. Devuelve 1 si se aplicó.
+int aplicarLutConcurrente(ImagenInfo *info, const LutPuntual *lut, int numHilos);
+
+#endif // POINT_H
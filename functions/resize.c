@@ -1,58 +1,87 @@
-// Redimensionado bilineal concurrente
+// Redimensionado concurrente: bilineal y separable con filtros
 
 #include "resize.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include <string.h>
 
-static inline unsigned char clampToByte(int value)
+// Coordenada origen y peso 8.8 de cada posición destino en un eje:
+// origen = i * (src - 1) / (dst - 1), i0 = parte entera, peso = fracción * 256
+static void calcularEje(int srcLargo, int dstLargo, int *i0, int *i1, int *pesos)
 {
-    if (value < 0) return 0;
-    if (value > 255) return 255;
-    return (unsigned char)value;
+    const double escala = (srcLargo > 1 && dstLargo > 1) ? (double)(srcLargo - 1) / (double)(dstLargo - 1) : 0.0;
+    for (int i = 0; i < dstLargo; i++)
+    {
+        double origen = escala * i;
+        int a = (int)floor(origen);
+        int peso = (int)lround((origen - a) * 256.0);
+        if (peso == 256)
+        {
+            a++;
+            peso = 0;
+        }
+        if (a > srcLargo - 1)
+            a = srcLargo - 1;
+        i0[i] = a;
+        i1[i] = a + 1 < srcLargo ? a + 1 : srcLargo - 1;
+        pesos[i] = peso;
+    }
+}
+
+// Reserva y llena las tablas en un solo bloque (liberar con free(tablas->offset0))
+static int crearTablasResize(TablasResize *t, int srcAncho, int srcAlto, int dstAncho, int dstAlto, int canales)
+{
+    int *bloque = (int *)malloc(((size_t)dstAncho * 3 + (size_t)dstAlto * 3) * sizeof(int));
+    if (!bloque)
+    {
+        fprintf(stderr, "Error de memoria al crear las tablas del redimensionado\n");
+        return 0;
+    }
+    t->offset0 = bloque;
+    t->offset1 = t->offset0 + dstAncho;
+    t->pesosX = t->offset1 + dstAncho;
+    t->fila0 = t->pesosX + dstAncho;
+    t->fila1 = t->fila0 + dstAlto;
+    t->pesosY = t->fila1 + dstAlto;
+
+    calcularEje(srcAncho, dstAncho, t->offset0, t->offset1, t->pesosX);
+    for (int x = 0; x < dstAncho; x++)
+    {
+        t->offset0[x] *= canales;
+        t->offset1[x] *= canales;
+        t->pesosX[x] = (256 - t->pesosX[x]) | (t->pesosX[x] << 16);
+    }
+    calcularEje(srcAlto, dstAlto, t->fila0, t->fila1, t->pesosY);
+    return 1;
 }
 
 // Hilo: procesa filas [filaInicio, filaFin) de la imagen destino
 static void *resizeBilinealHilo(void *argsPtr)
 {
     ResizeArgs *args = (ResizeArgs *)argsPtr;
-
-    const double scaleX = (args->srcAncho > 1 && args->dstAncho > 1) ? (double)(args->srcAncho - 1) / (double)(args->dstAncho - 1) : 0.0;
-    const double scaleY = (args->srcAlto > 1 && args->dstAlto > 1) ? (double)(args->srcAlto - 1) / (double)(args->dstAlto - 1) : 0.0;
+    const NucleosSimd *simd = nucleosSimd();
+    const TablasResize *t = args->tablas;
+    const size_t bytesFila = (size_t)args->srcAncho * args->canales;
 
     for (int y = args->filaInicio; y < args->filaFin; y++)
     {
-        double srcY = scaleY * y;
-        int y0 = (int)floor(srcY);
-        int y1 = y0 + 1;
-        if (y1 >= args->srcAlto) y1 = args->srcAlto - 1;
-        double wy = srcY - y0;
-
-        for (int x = 0; x < args->dstAncho; x++)
-        {
-            double srcX = scaleX * x;
-            int x0 = (int)floor(srcX);
-            int x1 = x0 + 1;
-            if (x1 >= args->srcAncho) x1 = args->srcAncho - 1;
-            double wx = srcX - x0;
-
-            for (int c = 0; c < args->canales; c++)
-            {
-                int p00 = args->srcPixeles[y0][x0][c];
-                int p10 = args->srcPixeles[y0][x1][c];
-                int p01 = args->srcPixeles[y1][x0][c];
-                int p11 = args->srcPixeles[y1][x1][c];
-
-                // Interpolación bilineal: mezcla en X y luego en Y
-                double top = p00 + wx * (p10 - p00);
-                double bottom = p01 + wx * (p11 - p01);
-                int value = (int)round(top + wy * (bottom - top));
-
-                args->dstPixeles[y][x][c] = clampToByte(value);
-            }
-        }
+        simd->resizeBilinealFila(args->srcPixeles[t->fila0[y]], args->srcPixeles[t->fila1[y]], t->pesosY[y],
+                                 t->offset0, t->offset1, t->pesosX, args->canales, bytesFila,
+                                 args->dstPixeles[y], 0, args->dstAncho);
     }
 
     return NULL;
 }
 
+// Adaptador para el pool: ejecuta resizeBilinealHilo sobre [filaInicio, filaFin)
+static void resizeBilinealRango(void *ctx, int inicio, int fin)
+{
+    ResizeArgs args = *(ResizeArgs *)ctx;
+    args.filaInicio = inicio;
+    args.filaFin = fin;
+    resizeBilinealHilo(&args);
+}
+
 int resizeBilinealConcurrente(ImagenInfo *info, int nuevoAncho, int nuevoAlto, int numHilos)
 {
     if (!info || !info->pixeles)
@@ -65,125 +94,521 @@ int resizeBilinealConcurrente(ImagenInfo *info, int nuevoAncho, int nuevoAlto, i
         fprintf(stderr, "Tamaño de destino inválido (%d x %d).\n", nuevoAncho, nuevoAlto);
         return 0;
     }
-    if (numHilos < 1 || numHilos > 4)
+    // numHilos <= 0: usar el valor por defecto (-j, IMG_HILOS o CPUs)
+    numHilos = poolResolverHilos(numHilos);
+
+    // Asignar imagen destino
+    ImagenInfo dst;
+    if (!crearImagen(&dst, nuevoAncho, nuevoAlto, info->canales))
     {
-        fprintf(stderr, "Número de hilos debe estar entre 1 y 4\n");
         return 0;
     }
 
-    // Asignar imagen destino
-    unsigned char ***dst = (unsigned char ***)malloc(nuevoAlto * sizeof(unsigned char **));
-    if (!dst)
+    // Coordenadas y pesos: una vez por redimensionado, compartidas por los hilos
+    TablasResize tablas;
+    if (!crearTablasResize(&tablas, info->ancho, info->alto, nuevoAncho, nuevoAlto, info->canales))
     {
-        fprintf(stderr, "Error de memoria al asignar filas destino\n");
+        liberarImagen(&dst);
         return 0;
     }
-    for (int y = 0; y < nuevoAlto; y++)
+
+    // Repartir las filas destino en el pool de hilos
+    ResizeArgs args;
+    args.srcPixeles = info->pixeles;
+    args.dstPixeles = dst.pixeles;
+    args.srcAncho = info->ancho;
+    args.srcAlto = info->alto;
+    args.canales = info->canales;
+    args.dstAncho = nuevoAncho;
+    args.dstAlto = nuevoAlto;
+    args.tablas = &tablas;
+    poolParaleloForTeselas(nuevoAlto, numHilos, poolFilasPorTesela((size_t)nuevoAncho * info->canales),
+                           resizeBilinealRango, &args);
+    free(tablas.offset0);
+
+    // Reemplazar imagen original por la redimensionada
+    const int srcAncho = info->ancho;
+    const int srcAlto = info->alto;
+    reemplazarImagen(info, &dst);
+
+    IMG_INFO("Redimensionado bilineal aplicado con %d hilos: %dx%d -> %dx%d (%s).\n",
+             numHilos,
+             srcAncho, srcAlto,
+             nuevoAncho, nuevoAlto,
+             info->canales == 1 ? "grises" : "RGB");
+
+    return 1;
+}
+
+
+// ---------- Redimensionado separable con filtros ----------
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static double filtroCaja(double x)
+{
+    return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+}
+
+static double filtroTriangulo(double x)
+{
+    x = fabs(x);
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+// Cúbico de Keys con a = -0.5 (B = 0, C = 0.5)
+static double filtroCatmullRom(double x)
+{
+    x = fabs(x);
+    if (x < 1.0)
+        return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0)
+        return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+static double sinc(double x)
+{
+    if (x == 0.0)
+        return 1.0;
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+static double filtroLanczos3(double x)
+{
+    return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+}
+
+static const struct
+{
+    const char *nombre;
+    double (*funcion)(double);
+    double soporte; // radio del filtro sin escalar
+} filtrosResize[NUM_FILTROS_RESIZE] = {
+    {"box", filtroCaja, 0.5},
+    {"triangle", filtroTriangulo, 1.0},
+    {"catmull-rom", filtroCatmullRom, 2.0},
+    {"lanczos3", filtroLanczos3, 3.0},
+};
+
+int filtroResizePorNombre(const char *nombre)
+{
+    for (int f = 0; f < NUM_FILTROS_RESIZE; f++)
+        if (strcmp(nombre, filtrosResize[f].nombre) == 0)
+            return f;
+    return -1;
+}
+
+const char *nombreFiltroResize(FiltroResize filtro)
+{
+    return filtro >= 0 && filtro < NUM_FILTROS_RESIZE ? filtrosResize[filtro].nombre : "?";
+}
+
+static void liberarTablaFiltro(TablaFiltro *t)
+{
+    free(t->inicio);
+    free(t->taps);
+    free(t->pesos);
+}
+
+// Pesos de un eje. Los centros de píxel se alinean ((i + 0.5) * escala - 0.5)
+// y, al reducir, el filtro se estira por la escala para promediar todos los
+// píxeles origen que cubre cada píxel destino. Los taps fuera de la imagen se
+// suman al píxel de borde (replicar bordes).
+static int crearTablaFiltro(TablaFiltro *t, int srcLargo, int dstLargo, FiltroResize filtro)
+{
+    const double escala = (double)srcLargo / dstLargo;
+    const double estirar = escala > 1.0 ? escala : 1.0;
+    const double soporte = filtrosResize[filtro].soporte * estirar;
+    double (*f)(double) = filtrosResize[filtro].funcion;
+
+    t->maxTaps = 2 * (int)ceil(soporte) + 1;
+    t->inicio = (int *)malloc((size_t)dstLargo * sizeof(int));
+    t->taps = (int *)malloc((size_t)dstLargo * sizeof(int));
+    t->pesos = (float *)calloc((size_t)dstLargo * t->maxTaps, sizeof(float));
+    double *acumulado = (double *)malloc((size_t)t->maxTaps * sizeof(double));
+    if (!t->inicio || !t->taps || !t->pesos || !acumulado)
     {
-        dst[y] = (unsigned char **)malloc(nuevoAncho * sizeof(unsigned char *));
-        if (!dst[y])
+        fprintf(stderr, "Error de memoria al crear los pesos del redimensionado\n");
+        liberarTablaFiltro(t);
+        free(acumulado);
+        return 0;
+    }
+
+    for (int i = 0; i < dstLargo; i++)
+    {
+        double centro = (i + 0.5) * escala - 0.5;
+        int lo = (int)ceil(centro - soporte);
+        int hi = (int)floor(centro + soporte);
+        int a = lo < 0 ? 0 : (lo > srcLargo - 1 ? srcLargo - 1 : lo);
+        int b = hi > srcLargo - 1 ? srcLargo - 1 : (hi < a ? a : hi);
+
+        for (int k = 0; k <= b - a; k++)
+            acumulado[k] = 0.0;
+        double suma = 0.0;
+        for (int j = lo; j <= hi; j++)
         {
-            fprintf(stderr, "Error de memoria al asignar columnas destino\n");
-            for (int i = 0; i < y; i++) free(dst[i]);
-            free(dst);
-            return 0;
+            int indice = j < a ? a : (j > b ? b : j);
+            double w = f((j - centro) / estirar);
+            acumulado[indice - a] += w;
+            suma += w;
         }
-        for (int x = 0; x < nuevoAncho; x++)
+
+        // Recortar pesos nulos en los extremos (caja y triángulo los tienen)
+        int primero = 0, ultimo = b - a;
+        while (primero < ultimo && acumulado[primero] == 0.0)
+            primero++;
+        while (ultimo > primero && acumulado[ultimo] == 0.0)
+            ultimo--;
+
+        float *w = t->pesos + (size_t)i * t->maxTaps;
+        t->inicio[i] = a + primero;
+        t->taps[i] = ultimo - primero + 1;
+        for (int k = primero; k <= ultimo; k++)
+            w[k - primero] = suma != 0.0 ? (float)(acumulado[k] / suma) : 1.0f / t->taps[i];
+    }
+
+    free(acumulado);
+    return 1;
+}
+
+// Pasada horizontal: filas origen [filaInicio, filaFin) -> temporal
+static void *resizeHorizontalHilo(void *argsPtr)
+{
+    ResizeFiltradoArgs *args = (ResizeFiltradoArgs *)argsPtr;
+    const TablaFiltro *t = args->tablaX;
+    const int canales = args->canales;
+    const size_t bytesSalida = (size_t)args->dstAncho * canales;
+
+    for (int y = args->filaInicio; y < args->filaFin; y++)
+    {
+        const unsigned char *fila = args->srcPixeles[y];
+        float *salida = args->temporal + (size_t)(y - args->filaTemporal) * bytesSalida;
+
+        for (int x = 0; x < args->dstAncho; x++)
         {
-            dst[y][x] = (unsigned char *)malloc(info->canales * sizeof(unsigned char));
-            if (!dst[y][x])
+            const unsigned char *p = fila + (size_t)t->inicio[x] * canales;
+            const float *w = t->pesos + (size_t)x * t->maxTaps;
+            const int taps = t->taps[x];
+
+            for (int c = 0; c < canales; c++)
             {
-                fprintf(stderr, "Error de memoria al asignar píxel destino\n");
-                for (int i = 0; i < y; i++)
-                {
-                    for (int j = 0; j < nuevoAncho; j++) free(dst[i][j]);
-                    free(dst[i]);
-                }
-                for (int j = 0; j < x; j++) free(dst[y][j]);
-                free(dst[y]);
-                free(dst);
-                return 0;
+                float suma = 0.0f;
+                for (int k = 0; k < taps; k++)
+                    suma += p[k * canales + c] * w[k];
+                salida[(size_t)x * canales + c] = suma;
             }
         }
     }
 
-    // Crear hilos y args
-    pthread_t *hilos = (pthread_t *)malloc(numHilos * sizeof(pthread_t));
-    ResizeArgs *args = (ResizeArgs *)malloc(numHilos * sizeof(ResizeArgs));
-    if (!hilos || !args)
+    return NULL;
+}
+
+// Pasada vertical: filas destino [filaInicio, filaFin) desde temporal, con el
+// núcleo SIMD de la convolución vertical (mismos pesos por fila)
+static void *resizeVerticalHilo(void *argsPtr)
+{
+    ResizeFiltradoArgs *args = (ResizeFiltradoArgs *)argsPtr;
+    const NucleosSimd *simd = nucleosSimd();
+    const TablaFiltro *t = args->tablaY;
+    const size_t bytesFila = (size_t)args->dstAncho * args->canales;
+
+    const float *filasLocales[64];
+    const float **filas = filasLocales;
+    if (t->maxTaps > 64)
     {
-        fprintf(stderr, "Error de memoria al asignar estructuras de hilos\n");
-        if (hilos) free(hilos);
-        if (args) free(args);
-        for (int y = 0; y < nuevoAlto; y++)
+        filas = (const float **)malloc((size_t)t->maxTaps * sizeof(float *));
+        if (!filas)
         {
-            for (int x = 0; x < nuevoAncho; x++) free(dst[y][x]);
-            free(dst[y]);
+            fprintf(stderr, "Error de memoria en la pasada vertical\n");
+            args->error = 1;
+            return NULL;
         }
-        free(dst);
+    }
+
+    for (int y = args->filaInicio; y < args->filaFin; y++)
+    {
+        for (int k = 0; k < t->taps[y]; k++)
+            filas[k] = args->temporal + (size_t)(t->inicio[y] + k - args->filaTemporal) * bytesFila;
+        simd->convolucionVerticalFila(filas, t->pesos + (size_t)y * t->maxTaps, t->taps[y],
+                                      args->dstPixeles[y], bytesFila);
+    }
+
+    if (filas != filasLocales)
+        free(filas);
+    return NULL;
+}
+
+// Adaptadores para el pool de las dos pasadas
+static void resizeHorizontalRango(void *ctx, int inicio, int fin)
+{
+    ResizeFiltradoArgs args = *(ResizeFiltradoArgs *)ctx;
+    args.filaInicio = inicio;
+    args.filaFin = fin;
+    resizeHorizontalHilo(&args);
+}
+
+static void resizeVerticalRango(void *ctx, int inicio, int fin)
+{
+    ResizeFiltradoArgs args = *(ResizeFiltradoArgs *)ctx;
+    args.filaInicio = inicio;
+    args.filaFin = fin;
+    resizeVerticalHilo(&args);
+    if (args.error)
+        ((ResizeFiltradoArgs *)ctx)->error = 1;
+}
+
+int resizeFiltradoConcurrente(ImagenInfo *info, int nuevoAncho, int nuevoAlto, FiltroResize filtro, int numHilos)
+{
+    if (!info || !info->pixeles)
+    {
+        fprintf(stderr, "No hay imagen cargada para redimensionar.\n");
+        return 0;
+    }
+    if (nuevoAncho <= 0 || nuevoAlto <= 0)
+    {
+        fprintf(stderr, "Tamaño de destino inválido (%d x %d).\n", nuevoAncho, nuevoAlto);
+        return 0;
+    }
+    if (filtro < 0 || filtro >= NUM_FILTROS_RESIZE)
+    {
+        fprintf(stderr, "Filtro de redimensionado inválido.\n");
         return 0;
     }
+    numHilos = poolResolverHilos(numHilos);
 
-    int filasPorHilo = (int)ceil((double)nuevoAlto / numHilos);
-    for (int i = 0; i < numHilos; i++)
+    TablaFiltro tablaX = {0}, tablaY = {0};
+    if (!crearTablaFiltro(&tablaX, info->ancho, nuevoAncho, filtro))
+        return 0;
+    if (!crearTablaFiltro(&tablaY, info->alto, nuevoAlto, filtro))
     {
-        args[i].srcPixeles = info->pixeles;
-        args[i].dstPixeles = dst;
-        args[i].srcAncho = info->ancho;
-        args[i].srcAlto = info->alto;
-        args[i].canales = info->canales;
-        args[i].dstAncho = nuevoAncho;
-        args[i].dstAlto = nuevoAlto;
-        args[i].filaInicio = i * filasPorHilo;
-        args[i].filaFin = (i + 1) * filasPorHilo;
-        if (args[i].filaInicio > nuevoAlto) args[i].filaInicio = nuevoAlto;
-        if (args[i].filaFin > nuevoAlto) args[i].filaFin = nuevoAlto;
+        liberarTablaFiltro(&tablaX);
+        return 0;
+    }
 
-        if (pthread_create(&hilos[i], NULL, resizeBilinealHilo, &args[i]) != 0)
-        {
-            fprintf(stderr, "Error al crear hilo %d\n", i);
-            // Join previos creados y limpiar
-            for (int j = 0; j < i; j++) pthread_join(hilos[j], NULL);
-            free(hilos);
-            free(args);
-            for (int y = 0; y < nuevoAlto; y++)
-            {
-                for (int x = 0; x < nuevoAncho; x++) free(dst[y][x]);
-                free(dst[y]);
-            }
-            free(dst);
-            return 0;
-        }
+    ImagenInfo dst;
+    float *temporal = (float *)malloc((size_t)info->alto * nuevoAncho * info->canales * sizeof(float));
+    if (!temporal || !crearImagen(&dst, nuevoAncho, nuevoAlto, info->canales))
+    {
+        if (!temporal)
+            fprintf(stderr, "Error de memoria al asignar buffer intermedio\n");
+        free(temporal);
+        liberarTablaFiltro(&tablaX);
+        liberarTablaFiltro(&tablaY);
+        return 0;
     }
 
-    for (int i = 0; i < numHilos; i++)
+    // Pasada horizontal sobre las filas origen y vertical sobre las destino
+    ResizeFiltradoArgs args;
+    args.srcPixeles = info->pixeles;
+    args.dstPixeles = dst.pixeles;
+    args.temporal = temporal;
+    args.filaTemporal = 0;
+    args.srcAncho = info->ancho;
+    args.canales = info->canales;
+    args.dstAncho = nuevoAncho;
+    args.tablaX = &tablaX;
+    args.tablaY = &tablaY;
+    args.error = 0;
+    poolParaleloForTeselas(info->alto, numHilos, poolFilasPorTesela((size_t)info->ancho * info->canales),
+                           resizeHorizontalRango, &args);
+    poolParaleloForTeselas(nuevoAlto, numHilos, poolFilasPorTesela((size_t)nuevoAncho * info->canales * sizeof(float)),
+                           resizeVerticalRango, &args);
+
+    free(temporal);
+    liberarTablaFiltro(&tablaX);
+    liberarTablaFiltro(&tablaY);
+    if (args.error)
     {
-        if (pthread_join(hilos[i], NULL) != 0)
+        liberarImagen(&dst);
+        return 0;
+    }
+
+    const int srcAncho = info->ancho;
+    const int srcAlto = info->alto;
+    reemplazarImagen(info, &dst);
+
+    IMG_INFO("Redimensionado %s aplicado con %d hilos: %dx%d -> %dx%d (%s).\n",
+             nombreFiltroResize(filtro), numHilos,
+             srcAncho, srcAlto,
+             nuevoAncho, nuevoAlto,
+             info->canales == 1 ? "grises" : "RGB");
+
+    return 1;
+}
+
+// ---------- Redimensionado por franjas ----------
+
+struct ResizeFranjas
+{
+    int srcAncho, srcAlto, dstAncho, dstAlto, canales;
+    int filtro;            // -1 = bilineal
+    TablasResize tablas;   // bilineal
+    TablaFiltro tablaX;    // con filtro
+    TablaFiltro tablaY;
+    int *desde;            // por fila destino: primera fila origen que aún hace falta
+    int *hasta;            // por fila destino: fin de las filas origen que necesita
+    unsigned char **srcPixeles; // srcAlto punteros; solo valen los de la franja actual
+    unsigned char **dstPixeles; // dstAlto punteros; ídem
+    float *temporal;       // pasada horizontal de la franja (con filtro)
+    size_t filasTemporal;  // capacidad de temporal en filas
+};
+
+// El pool reparte [0, total): base desplaza el rango a las filas de la franja
+typedef struct
+{
+    ResizeArgs bilineal;
+    ResizeFiltradoArgs filtrado;
+    int base;
+} FranjaResizeCtx;
+
+static void franjaBilinealRango(void *ctx, int inicio, int fin)
+{
+    FranjaResizeCtx *f = (FranjaResizeCtx *)ctx;
+    resizeBilinealRango(&f->bilineal, f->base + inicio, f->base + fin);
+}
+
+static void franjaHorizontalRango(void *ctx, int inicio, int fin)
+{
+    FranjaResizeCtx *f = (FranjaResizeCtx *)ctx;
+    resizeHorizontalRango(&f->filtrado, f->base + inicio, f->base + fin);
+}
+
+static void franjaVerticalRango(void *ctx, int inicio, int fin)
+{
+    FranjaResizeCtx *f = (FranjaResizeCtx *)ctx;
+    resizeVerticalRango(&f->filtrado, f->base + inicio, f->base + fin);
+}
+
+void resizeFranjasLiberar(ResizeFranjas *r)
+{
+    if (!r)
+        return;
+    free(r->tablas.offset0);
+    liberarTablaFiltro(&r->tablaX);
+    liberarTablaFiltro(&r->tablaY);
+    free(r->desde);
+    free(r->hasta);
+    free(r->srcPixeles);
+    free(r->dstPixeles);
+    free(r->temporal);
+    free(r);
+}
+
+ResizeFranjas *resizeFranjasCrear(int srcAncho, int srcAlto, int dstAncho, int dstAlto, int canales, int filtro)
+{
+    if (srcAncho <= 0 || srcAlto <= 0 || dstAncho <= 0 || dstAlto <= 0 || filtro >= NUM_FILTROS_RESIZE)
+    {
+        fprintf(stderr, "Tamaño de destino inválido (%d x %d).\n", dstAncho, dstAlto);
+        return NULL;
+    }
+    ResizeFranjas *r = (ResizeFranjas *)calloc(1, sizeof(ResizeFranjas));
+    if (!r)
+        return NULL;
+    r->srcAncho = srcAncho;
+    r->srcAlto = srcAlto;
+    r->dstAncho = dstAncho;
+    r->dstAlto = dstAlto;
+    r->canales = canales;
+    r->filtro = filtro < 0 ? -1 : filtro;
+
+    r->desde = (int *)malloc((size_t)dstAlto * sizeof(int));
+    r->hasta = (int *)malloc((size_t)dstAlto * sizeof(int));
+    r->srcPixeles = (unsigned char **)calloc((size_t)srcAlto, sizeof(unsigned char *));
+    r->dstPixeles = (unsigned char **)calloc((size_t)dstAlto, sizeof(unsigned char *));
+    int ok = r->desde && r->hasta && r->srcPixeles && r->dstPixeles;
+    if (ok && r->filtro < 0)
+        ok = crearTablasResize(&r->tablas, srcAncho, srcAlto, dstAncho, dstAlto, canales);
+    else if (ok)
+        ok = crearTablaFiltro(&r->tablaX, srcAncho, dstAncho, (FiltroResize)filtro) &&
+             crearTablaFiltro(&r->tablaY, srcAlto, dstAlto, (FiltroResize)filtro);
+    if (!ok)
+    {
+        fprintf(stderr, "Error de memoria al preparar el redimensionado por franjas\n");
+        resizeFranjasLiberar(r);
+        return NULL;
+    }
+
+    // Rango de cada fila, hecho monótono: mínimo de lo que queda por delante
+    // y máximo de lo que ya se pidió
+    for (int y = 0; y < dstAlto; y++)
+    {
+        if (r->filtro < 0)
         {
-            fprintf(stderr, "Error al esperar hilo %d\n", i);
+            r->desde[y] = r->tablas.fila0[y];
+            r->hasta[y] = r->tablas.fila1[y] + 1;
         }
+        else
+        {
+            r->desde[y] = r->tablaY.inicio[y];
+            r->hasta[y] = r->tablaY.inicio[y] + r->tablaY.taps[y];
+        }
+        if (y > 0 && r->hasta[y] < r->hasta[y - 1])
+            r->hasta[y] = r->hasta[y - 1];
     }
-
-    // Reemplazar imagen original por la redimensionada
-    for (int y = 0; y < info->alto; y++)
+    for (int y = dstAlto - 2; y >= 0; y--)
     {
-        for (int x = 0; x < info->ancho; x++) free(info->pixeles[y][x]);
-        free(info->pixeles[y]);
+        if (r->desde[y] > r->desde[y + 1])
+            r->desde[y] = r->desde[y + 1];
     }
-    free(info->pixeles);
+    return r;
+}
 
-    info->pixeles = dst;
-    info->ancho = nuevoAncho;
-    info->alto = nuevoAlto;
+void resizeFranjasFilasOrigen(const ResizeFranjas *r, int y, int *desde, int *hasta)
+{
+    *desde = r->desde[y];
+    *hasta = r->hasta[y];
+}
 
-    free(hilos);
-    free(args);
+int resizeFranjasProcesar(ResizeFranjas *r, unsigned char *const *filasOrigen, int desde, int hasta,
+                          unsigned char *const *filasDestino, int y0, int y1, int numHilos)
+{
+    if (y0 >= y1)
+        return 1;
+    numHilos = poolResolverHilos(numHilos);
+    for (int y = desde; y < hasta; y++)
+        r->srcPixeles[y] = filasOrigen[y - desde];
+    for (int y = y0; y < y1; y++)
+        r->dstPixeles[y] = filasDestino[y - y0];
 
-    printf("Redimensionado bilineal aplicado con %d hilos: %dx%d -> %dx%d (%s).\n",
-           numHilos,
-           args[0].srcAncho, args[0].srcAlto,
-           nuevoAncho, nuevoAlto,
-           info->canales == 1 ? "grises" : "RGB");
+    FranjaResizeCtx ctx;
+    if (r->filtro < 0)
+    {
+        ResizeArgs args = {r->srcPixeles, r->dstPixeles, r->srcAncho, r->srcAlto, r->canales,
+                           r->dstAncho, r->dstAlto, &r->tablas, 0, 0};
+        ctx.bilineal = args;
+        ctx.base = y0;
+        poolParaleloForTeselas(y1 - y0, numHilos, poolFilasPorTesela((size_t)r->dstAncho * r->canales),
+                               franjaBilinealRango, &ctx);
+        return 1;
+    }
 
-    return 1;
-}
\ No newline at end of file
+    // Con filtro: pasada horizontal de las filas origen de la franja
+    const size_t bytesTemporal = (size_t)r->dstAncho * r->canales;
+    const int primera = r->desde[y0];
+    const int filas = hasta - primera;
+    if ((size_t)filas > r->filasTemporal)
+    {
+        float *nuevo = (float *)realloc(r->temporal, (size_t)filas * bytesTemporal * sizeof(float));
+        if (!nuevo)
+        {
+            fprintf(stderr, "Error de memoria al asignar buffer intermedio\n");
+            return 0;
+        }
+        r->temporal = nuevo;
+        r->filasTemporal = (size_t)filas;
+    }
+    ResizeFiltradoArgs args = {r->srcPixeles, r->dstPixeles, r->temporal, primera, r->srcAncho, r->canales,
+                               r->dstAncho, &r->tablaX, &r->tablaY, 0, 0, 0};
+    ctx.filtrado = args;
+    ctx.base = primera;
+    poolParaleloForTeselas(filas, numHilos, poolFilasPorTesela((size_t)r->srcAncho * r->canales),
+                           franjaHorizontalRango, &ctx);
+    ctx.base = y0;
+    poolParaleloForTeselas(y1 - y0, numHilos, poolFilasPorTesela(bytesTemporal * sizeof(float)),
+                           franjaVerticalRango, &ctx);
+    return !ctx.filtrado.error;
+}
@@ -9,20 +9,108 @@
 #include <math.h>
 
 // Function declarations for resize operations
+
+// Tablas de coordenadas y pesos (8.8) del redimensionado bilineal. Se
+// calculan una vez por redimensionado y los hilos solo las leen.
+typedef struct
+{
+    int *offset0;   // por columna destino: x0 * canales (cabe en int, ver IMAGEN_BYTES_FILA_MAXIMO)
+    int *offset1;   // por columna destino: x1 * canales
+    int *pesosX;    // por columna destino: (256 - wx) | wx << 16
+    int *fila0;     // por fila destino: y0
+    int *fila1;     // por fila destino: y1
+    int *pesosY;    // por fila destino: wy en [0, 256]
+} TablasResize;
+
 typedef struct
 {
-    unsigned char ***srcPixeles;
-    unsigned char ***dstPixeles;
+    unsigned char **srcPixeles;
+    unsigned char **dstPixeles;
     int srcAncho;
     int srcAlto;
     int canales;
     int dstAncho;
     int dstAlto;
+    const TablasResize *tablas;
     int filaInicio;
     int filaFin; // exclusivo
 } ResizeArgs;
 
 
+// Filtros del redimensionado separable
+typedef enum
+{
+    FILTRO_CAJA,        // "box": promedio del área (vecino más cercano al ampliar)
+    FILTRO_TRIANGULO,   // "triangle": lineal
+    FILTRO_CATMULL_ROM, // "catmull-rom": cúbico nítido
+    FILTRO_LANCZOS3,    // "lanczos3": sinc con ventana de 3 lóbulos
+    NUM_FILTROS_RESIZE
+} FiltroResize;
+
+// Pesos de un eje del redimensionado separable: la posición destino i usa
+// taps[i] píxeles origen contiguos desde inicio[i], con los pesos
+// pesos[i * maxTaps ...] (suman 1; los bordes ya están replicados).
+typedef struct
+{
+    int *inicio;
+    int *taps;
+    float *pesos;
+    int maxTaps;
+} TablaFiltro;
+
+// Estructura para los hilos del redimensionado separable (dos pasadas 1D).
+// La pasada horizontal escribe srcAlto filas de dstAncho en temporal (float)
+// y la vertical las combina en las filas destino.
+typedef struct
+{
+    unsigned char **srcPixeles;
+    unsigned char **dstPixeles;
+    float *temporal;  // filas origen [filaTemporal, ...) * dstAncho * canales
+    int filaTemporal; // fila origen guardada al principio de temporal
+    int srcAncho;
+    int canales;
+    int dstAncho;
+    const TablaFiltro *tablaX;
+    const TablaFiltro *tablaY;
+    int filaInicio;
+    int filaFin; // exclusivo
+    int error;   // algún hilo se quedó sin memoria (filas sin escribir)
+} ResizeFiltradoArgs;
+
 int resizeBilinealConcurrente(ImagenInfo *info, int nuevoAncho, int nuevoAlto, int numHilos);
 
+// Redimensiona con un filtro separable en dos pasadas sobre el pool. Al
+// reducir, el soporte del filtro se ensancha con la escala, así que una
+// reducción grande se hace en una sola pasada sin aliasing.
+// numHilos <= 0 usa el número de hilos por defecto del pool.
+int resizeFiltradoConcurrente(ImagenInfo *info, int nuevoAncho, int nuevoAlto, FiltroResize filtro, int numHilos);
+
+// Redimensionado por franjas de filas (bilineal o con filtro): da los mismos
+// bytes que la imagen completa, pero solo necesita las filas origen que usa
+// cada tramo de filas destino.
+typedef struct ResizeFranjas ResizeFranjas;
+
+// filtro: un FiltroResize o -1 para el bilineal. Devuelve NULL si falla.
+ResizeFranjas *resizeFranjasCrear(int srcAncho, int srcAlto, int dstAncho, int dstAlto, int canales, int filtro);
+
+// Filas origen [*desde, *hasta) que necesita la fila destino y. Ninguno de
+// los dos decrece con y: las filas por debajo de desde ya no harán falta y la
+// fila y se puede calcular en cuanto llega la fila origen hasta - 1.
+void resizeFranjasFilasOrigen(const ResizeFranjas *r, int y, int *desde, int *hasta);
+
+// Calcula las filas destino [y0, y1). filasOrigen[k] es la fila origen
+// desde + k; [desde, hasta) debe cubrir lo que piden esas filas destino.
+// filasDestino[k] recibe la fila destino y0 + k. Devuelve 1 si todo fue bien.
+int resizeFranjasProcesar(ResizeFranjas *r, unsigned char *const *filasOrigen, int desde, int hasta,
+                          unsigned char *const *filasDestino, int y0, int y1, int numHilos);
+
+void resizeFranjasLiberar(ResizeFranjas *r);
+
+// Filtro a partir de su nombre ("box", "triangle", "catmull-rom", "lanczos3");
+// -1 si no existe.
+int filtroResizePorNombre(const char *nombre);
+
+// Nombre del filtro.
+const char *nombreFiltroResize(FiltroResize filtro);
+
 #endif // RESIZE_H
\ No newline at end of file
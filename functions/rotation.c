@@ -1,219 +1,374 @@
 #include "rotation.h"
+#include "flip.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <pthread.h>
-#include <math.h> 
+#include "simd.h"
+#include "thread_pool.h"
+#include <math.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
 
-unsigned char ***asignarMatriz(int alto, int ancho, int canales)
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Lado de los bloques de la transposición: un bloque de origen y uno de
+// destino de 32x32 píxeles caben a la vez en la L1
+#define BLOQUE_ROTACION 32
+
+// Rotación de 90° o 270° como transposición por bloques. El píxel destino
+// (x, y) viene de la fila origen filaBase + filaPaso * x y de la columna
+// colBase + colPaso * y. Dentro de cada bloque se lee el origen por filas y
+// se escribe el destino por columnas, sin salir de la caché.
+static void transponerRotando(const RotacionArgs *r, int filaBase, int filaPaso, int colBase, int colPaso)
 {
-    unsigned char ***matriz = (unsigned char ***)malloc(alto * sizeof(unsigned char **));
-    if (!matriz)
-    {
-        fprintf(stderr, "Error de memoria al asignar filas\n");
-        return NULL;
-    }
+    const NucleosSimd *simd = nucleosSimd();
+    const int canales = r->canales;
 
-    for (int y = 0; y < alto; y++)
+    for (int by = r->inicioY; by < r->finY; by += BLOQUE_ROTACION)
     {
-        matriz[y] = (unsigned char **)malloc(ancho * sizeof(unsigned char *));
-        if (!matriz[y])
+        const int finBy = by + BLOQUE_ROTACION < r->finY ? by + BLOQUE_ROTACION : r->finY;
+        for (int bx = 0; bx < r->anchoDestino; bx += BLOQUE_ROTACION)
         {
-            fprintf(stderr, "Error de memoria al asignar columnas en fila %d\n", y);
-            // Liberar memoria ya asignada
-            for (int i = 0; i < y; i++)
-            {
-                free(matriz[i]);
-            }
-            free(matriz);
-            return NULL;
-        }
+            const int finBx = bx + BLOQUE_ROTACION < r->anchoDestino ? bx + BLOQUE_ROTACION : r->anchoDestino;
+            int y = by;
 
-        for (int x = 0; x < ancho; x++)
-        {
-            matriz[y][x] = (unsigned char *)malloc(canales * sizeof(unsigned char));
-            if (!matriz[y][x])
+            // Grises: sub-bloques de 8x8 transpuestos en registros
+            if (canales == 1)
             {
-                fprintf(stderr, "Error de memoria al asignar canales en (%d,%d)\n", y, x);
-                // Liberar memoria ya asignada
-                for (int i = 0; i <= y; i++)
+                for (; y + 8 <= finBy; y += 8)
                 {
-                    int maxX = (i == y) ? x : ancho;
-                    for (int j = 0; j < maxX; j++)
+                    int x = bx;
+                    for (; x + 8 <= finBx; x += 8)
                     {
-                        free(matriz[i][j]);
+                        const unsigned char *origen[8];
+                        unsigned char *destino[8];
+                        // Con colPaso = -1 las 8 columnas origen van al revés:
+                        // se leen en orden creciente y se invierten las filas destino
+                        const int col = colPaso > 0 ? colBase + y : colBase - y - 7;
+                        for (int k = 0; k < 8; k++)
+                        {
+                            origen[k] = r->origen[filaBase + filaPaso * (x + k)] + col;
+                            destino[k] = r->destino[colPaso > 0 ? y + k : y + 7 - k] + x;
+                        }
+                        simd->transponer8x8(origen, destino);
+                    }
+                    for (; x < finBx; x++)
+                    {
+                        const unsigned char *fila = r->origen[filaBase + filaPaso * x];
+                        for (int k = y; k < y + 8; k++)
+                            r->destino[k][x] = fila[colBase + colPaso * k];
                     }
-                    free(matriz[i]);
                 }
-                free(matriz);
-                return NULL;
             }
 
-            // Inicializar píxeles a negro (0)
-            for (int c = 0; c < canales; c++)
+            // Resto del bloque (y RGB): filas origen recorridas en orden
+            for (int x = bx; x < finBx; x++)
             {
-                matriz[y][x][c] = 0;
+                const unsigned char *fila = r->origen[filaBase + filaPaso * x];
+                for (int k = y; k < finBy; k++)
+                {
+                    const unsigned char *p = fila + (size_t)(colBase + colPaso * k) * canales;
+                    unsigned char *d = r->destino[k] + (size_t)x * canales;
+                    for (int c = 0; c < canales; c++)
+                        d[c] = p[c];
+                }
             }
         }
     }
-    return matriz;
 }
 
-void liberarMatriz(unsigned char ***matriz, int alto, int ancho)
+// 180° sobre un destino aparte (rotarImagenConFondo usa rotar180EnSitio):
+// cada fila destino es la fila origen simétrica recorrida al revés
+static void rotar180Filas(const RotacionArgs *r)
+{
+    const int canales = r->canales;
+    for (int y = r->inicioY; y < r->finY; y++)
+    {
+        const unsigned char *fila = r->origen[r->altoOrigen - 1 - y];
+        unsigned char *d = r->destino[y];
+        for (int x = 0; x < r->anchoDestino; x++)
+        {
+            const unsigned char *p = fila + (size_t)(r->anchoOrigen - 1 - x) * canales;
+            for (int c = 0; c < canales; c++)
+                d[(size_t)x * canales + c] = p[c];
+        }
+    }
+}
+
+// Coordenadas origen en punto fijo 32.32: el avance por píxel se suma
+// entero, sin deriva apreciable a lo largo de una fila
+#define BITS_FRACCION_ROTACION 32
+
+// Intersecta [*xMin, *xMax] con los x que cumplen lo <= s0 + x * d <= hi
+static void limitarTramo(double s0, double d, double lo, double hi, double *xMin, double *xMax)
 {
-    if (!matriz)
+    if (fabs(d) < 1e-12)
+    {
+        if (s0 < lo || s0 > hi)
+            *xMax = *xMin - 1; // vacío
         return;
+    }
+    double t1 = (lo - s0) / d;
+    double t2 = (hi - s0) / d;
+    if (t1 > t2)
+    {
+        double t = t1;
+        t1 = t2;
+        t2 = t;
+    }
+    if (t1 > *xMin)
+        *xMin = t1;
+    if (t2 < *xMax)
+        *xMax = t2;
+}
 
-    for (int y = 0; y < alto; y++)
+// Tramo [*ini, *fin) de la fila donde s = s0 + x * (dx, dy) cae en
+// [lo, hiX] x [lo, hiY], ensanchado (margen > 0) o encogido (margen < 0)
+// para cubrir el redondeo
+static void tramoFila(double sx0, double sy0, double dx, double dy, double lo, double hiX, double hiY,
+                      int margen, int ancho, int *ini, int *fin)
+{
+    double xMin = 0.0, xMax = ancho - 1;
+    limitarTramo(sx0, dx, lo, hiX, &xMin, &xMax);
+    limitarTramo(sy0, dy, lo, hiY, &xMin, &xMax);
+    if (xMax < xMin)
     {
-        if (matriz[y])
+        *ini = *fin = 0;
+        return;
+    }
+    int a = (int)ceil(xMin) - margen;
+    int b = (int)floor(xMax) + 1 + margen;
+    *ini = a < 0 ? 0 : (a > ancho ? ancho : a);
+    *fin = b > ancho ? ancho : (b < *ini ? *ini : b);
+}
+
+static void pintarFondo(const RotacionArgs *r, unsigned char *d, int desde, int hasta)
+{
+    for (int x = desde; x < hasta; x++)
+        for (int c = 0; c < r->canales; c++)
+            d[(size_t)x * r->canales + c] = r->fondo[c];
+}
+
+// Mezcla bilineal 8.8 de los cuatro vecinos (p00 arriba-izq., p10 arriba-der.)
+static inline unsigned char mezclaRotacion(int p00, int p10, int p01, int p11, int fx, int fy)
+{
+    int arriba = p00 * (256 - fx) + p10 * fx;
+    int abajo = p01 * (256 - fx) + p11 * fx;
+    return (unsigned char)((arriba * (256 - fy) + abajo * fy + 32768) >> 16);
+}
+
+// Píxeles del borde: los vecinos fuera del origen toman el color de fondo,
+// así el contorno queda suavizado contra el fondo
+static void rotarTramoBorde(const RotacionArgs *r, unsigned char *d, int desde, int hasta,
+                            int64_t sx, int64_t sy, int64_t dx, int64_t dy)
+{
+    const int canales = r->canales;
+    for (int x = desde; x < hasta; x++, sx += dx, sy += dy)
+    {
+        // >> de un negativo es desplazamiento aritmético en GCC (= floor)
+        const int x0 = (int)(sx >> BITS_FRACCION_ROTACION);
+        const int y0 = (int)(sy >> BITS_FRACCION_ROTACION);
+        const int fx = (int)(sx >> (BITS_FRACCION_ROTACION - 8)) & 255;
+        const int fy = (int)(sy >> (BITS_FRACCION_ROTACION - 8)) & 255;
+        const unsigned char *p[4];
+        for (int k = 0; k < 4; k++)
         {
-            for (int x = 0; x < ancho; x++)
-            {
-                free(matriz[y][x]);
-            }
-            free(matriz[y]);
+            const int xx = x0 + (k & 1), yy = y0 + (k >> 1);
+            p[k] = (xx >= 0 && xx < r->anchoOrigen && yy >= 0 && yy < r->altoOrigen)
+                       ? r->origen[yy] + (size_t)xx * canales
+                       : r->fondo;
         }
+        for (int c = 0; c < canales; c++)
+            d[(size_t)x * canales + c] = mezclaRotacion(p[0][c], p[1][c], p[2][c], p[3][c], fx, fy);
     }
-    free(matriz);
 }
 
-void *rotarImagenHilo(void *args)
+// Píxeles interiores: los cuatro vecinos están dentro del origen
+static void rotarTramoInterior(const RotacionArgs *r, unsigned char *d, int desde, int hasta,
+                               int64_t sx, int64_t sy, int64_t dx, int64_t dy)
 {
-    RotacionArgs *rArgs = (RotacionArgs *)args;
-    int angulo = (int)rArgs->angulo; // Convertir a entero (90, 180, 270)
+    const int canales = r->canales;
+    for (int x = desde; x < hasta; x++, sx += dx, sy += dy)
+    {
+        const int x0 = (int)(sx >> BITS_FRACCION_ROTACION);
+        const int y0 = (int)(sy >> BITS_FRACCION_ROTACION);
+        const int fx = (int)(sx >> (BITS_FRACCION_ROTACION - 8)) & 255;
+        const int fy = (int)(sy >> (BITS_FRACCION_ROTACION - 8)) & 255;
+        const unsigned char *a = r->origen[y0] + (size_t)x0 * canales;
+        const unsigned char *b = r->origen[y0 + 1] + (size_t)x0 * canales;
+        for (int c = 0; c < canales; c++)
+            d[(size_t)x * canales + c] = mezclaRotacion(a[c], a[c + canales], b[c], b[c + canales], fx, fy);
+    }
+}
+
+// Ángulo arbitrario por transformación inversa: el píxel destino (x, y) viene
+// de origen = centroOrigen + R(-angulo) * (destino - centroDestino). A lo
+// largo de una fila el origen avanza (cos, -sin) por píxel, así que solo se
+// calcula el inicio de cada fila; los tramos que caen fuera del origen se
+// obtienen analíticamente y se rellenan con el fondo sin muestrear.
+static void rotarLibreFilas(const RotacionArgs *r)
+{
+    const double escala = (double)((int64_t)1 << BITS_FRACCION_ROTACION);
+    const double dx = r->cosAngulo, dy = -r->sinAngulo;
+    const int64_t pasoX = (int64_t)llround(dx * escala);
+    const int64_t pasoY = (int64_t)llround(dy * escala);
+    const int ancho = r->anchoDestino;
 
-    for (int y = rArgs->inicioY; y < rArgs->finY; y++)
+    for (int y = r->inicioY; y < r->finY; y++)
     {
-        for (int x = 0; x < rArgs->anchoDestino; x++)
-        {
-            int xOrigen, yOrigen;
+        unsigned char *d = r->destino[y];
+        const double ry = y - r->centroYDestino;
+        const double sx0 = r->centroXOrigen - r->cosAngulo * r->centroXDestino + r->sinAngulo * ry;
+        const double sy0 = r->centroYOrigen + r->sinAngulo * r->centroXDestino + r->cosAngulo * ry;
 
-            // Mapeo directo de coordenadas según el ángulo
-            switch (angulo)
-            {
-            case 90:
-                // 90° horario: (x,y) -> (y, alto-1-x)
-                xOrigen = y;
-                yOrigen = rArgs->anchoDestino - 1 - x;
-                break;
-            case 180:
-                // 180°: (x,y) -> (ancho-1-x, alto-1-y)
-                xOrigen = rArgs->anchoDestino - 1 - x;
-                yOrigen = rArgs->altoDestino - 1 - y;
-                break;
-            case 270:
-                // 270° horario: (x,y) -> (alto-1-y, x)
-                xOrigen = rArgs->altoDestino - 1 - y;
-                yOrigen = x;
-                break;
-            default:
-                continue; // Saltar píxel si ángulo no válido
-            }
+        // Exterior: algún vecino dentro (s en (-1, n)); interior: todos (s en [0, n - 1))
+        int iniExt, finExt, iniInt, finInt;
+        tramoFila(sx0, sy0, dx, dy, -1.0, r->anchoOrigen, r->altoOrigen, 1, ancho, &iniExt, &finExt);
+        tramoFila(sx0, sy0, dx, dy, 0.0, r->anchoOrigen - 1, r->altoOrigen - 1, -1, ancho, &iniInt, &finInt);
+        if (iniInt < iniExt || finInt > finExt || finInt <= iniInt)
+            iniInt = finInt = finExt;
 
-            // Verificar límites
-            if (xOrigen >= 0 && xOrigen < rArgs->anchoOrigen &&
-                yOrigen >= 0 && yOrigen < rArgs->altoOrigen)
-            {
-                // Copia directa del píxel (sin interpolación)
-                for (int c = 0; c < rArgs->canales; c++)
-                {
-                    rArgs->destino[y][x][c] = rArgs->origen[yOrigen][xOrigen][c];
-                }
-            }
-            // Si está fuera de límites, el píxel queda negro (inicializado en asignarMatriz)
-        }
+        const int64_t sx = (int64_t)llround(sx0 * escala);
+        const int64_t sy = (int64_t)llround(sy0 * escala);
+        pintarFondo(r, d, 0, iniExt);
+        rotarTramoBorde(r, d, iniExt, iniInt, sx + pasoX * iniExt, sy + pasoY * iniExt, pasoX, pasoY);
+        rotarTramoInterior(r, d, iniInt, finInt, sx + pasoX * iniInt, sy + pasoY * iniInt, pasoX, pasoY);
+        rotarTramoBorde(r, d, finInt, finExt, sx + pasoX * finInt, sy + pasoY * finInt, pasoX, pasoY);
+        pintarFondo(r, d, finExt, ancho);
     }
+}
+
+void *rotarImagenHilo(void *args)
+{
+    RotacionArgs *rArgs = (RotacionArgs *)args;
+
+    // El ángulo se resuelve una vez por rango, no por píxel. Los múltiplos
+    // de 90 llegan exactos (rotarImagenConFondo los ajusta).
+    if (rArgs->angulo == 90.0f)
+        // 90° horario: destino (x,y) <- origen fila alto-1-x, columna y
+        transponerRotando(rArgs, rArgs->altoOrigen - 1, -1, 0, 1);
+    else if (rArgs->angulo == 180.0f)
+        rotar180Filas(rArgs);
+    else if (rArgs->angulo == 270.0f)
+        // 270° horario: destino (x,y) <- origen fila x, columna ancho-1-y
+        transponerRotando(rArgs, 0, 1, rArgs->anchoOrigen - 1, -1);
+    else
+        rotarLibreFilas(rArgs);
     return NULL;
 }
 
-void rotarImagenConcurrente(ImagenInfo *info, float angulo)
+// Adaptador para el pool: ejecuta rotarImagenHilo sobre [inicioY, finY)
+static void rotarImagenRango(void *ctx, int inicio, int fin)
+{
+    RotacionArgs args = *(RotacionArgs *)ctx;
+    args.inicioY = inicio;
+    args.finY = fin;
+    rotarImagenHilo(&args);
+}
+
+int rotarImagenConcurrente(ImagenInfo *info, float angulo, int numHilos)
+{
+    return rotarImagenConFondo(info, angulo, NULL, numHilos);
+}
+
+int rotarImagenConFondo(ImagenInfo *info, float angulo, const unsigned char *fondo, int numHilos)
 {
     if (!info->pixeles)
     {
-        printf("No hay imagen cargada.\n");
-        return;
+        fprintf(stderr, "No hay imagen cargada.\n");
+        return 0;
+    }
+    if (!isfinite(angulo))
+    {
+        fprintf(stderr, "Ángulo de rotación inválido.\n");
+        return 0;
     }
 
-    // Normalizar ángulo y redondear al múltiplo de 90 más cercano
-    int anguloInt = ((int)(angulo + 45) / 90) * 90;
-    anguloInt = anguloInt % 360;
-    if (anguloInt < 0)
-        anguloInt += 360;
+    // Normalizar a [0, 360) y ajustar a múltiplo de 90 si está a menos de
+    // una milésima de grado
+    double normalizado = fmod((double)angulo, 360.0);
+    if (normalizado < 0)
+        normalizado += 360.0;
+    const double cuartos = floor(normalizado / 90.0 + 0.5);
+    if (fabs(normalizado - cuartos * 90.0) < 1e-3)
+        normalizado = fmod(cuartos * 90.0, 360.0);
 
-    // Validar que sea múltiplo de 90
-    if (anguloInt != 90 && anguloInt != 180 && anguloInt != 270)
+    if (normalizado == 0.0)
     {
-        printf("Error: Solo se soportan rotaciones de 90°, 180° y 270°.\n");
-        printf("Ángulo %.1f° redondeado a %d° no es válido.\n", angulo, anguloInt);
-        return;
+        IMG_INFO("Rotación de 0 grados: la imagen no cambia.\n");
+        return 1;
     }
 
-    printf("Rotando imagen %d grados...\n", anguloInt);
+    IMG_INFO("Rotando imagen %.1f grados...\n", normalizado);
+
+    // 180° no cambia las dimensiones: se hace en el sitio, sin reservar
+    if (normalizado == 180.0)
+        return rotar180EnSitio(info, numHilos);
 
-    // Calcular nuevas dimensiones según el ángulo
+    // Dimensiones: exactas para 90/270; para el resto, el lienzo que
+    // contiene la imagen girada completa
+    const double rad = normalizado * M_PI / 180.0;
+    const double cosA = cos(rad), sinA = sin(rad);
+    const int recto = normalizado == 90.0 || normalizado == 270.0;
     int nuevoAncho, nuevoAlto;
-    switch (anguloInt)
+    if (recto)
     {
-    case 90:
-    case 270:
         // Para 90° y 270°, intercambiar ancho y alto
         nuevoAncho = info->alto;
         nuevoAlto = info->ancho;
-        break;
-    case 180:
-        // Para 180°, las dimensiones se mantienen
-        nuevoAncho = info->ancho;
-        nuevoAlto = info->alto;
-        break;
-    default:
-        return; 
     }
-
-    printf("Dimensiones: %dx%d → %dx%d\n", info->ancho, info->alto, nuevoAncho, nuevoAlto);
-
-    unsigned char ***nuevaMatriz = asignarMatriz(nuevoAlto, nuevoAncho, info->canales);
-    if (!nuevaMatriz)
+    else
     {
-        fprintf(stderr, "Error al asignar memoria para imagen rotada\n");
-        return;
-    }
-
-    const int numHilos = 4; // Número configurable de hilos
-    pthread_t hilos[numHilos];
-    RotacionArgs args[numHilos];
-    int filasPorHilo = (int)ceil((double)nuevoAlto / numHilos);
-
-    for (int i = 0; i < numHilos; i++)
-    {
-        args[i].origen = info->pixeles;
-        args[i].destino = nuevaMatriz;
-        args[i].anchoOrigen = info->ancho;
-        args[i].altoOrigen = info->alto;
-        args[i].anchoDestino = nuevoAncho;
-        args[i].altoDestino = nuevoAlto;
-        args[i].canales = info->canales;
-        args[i].angulo = (float)anguloInt;
-        args[i].inicioY = i * filasPorHilo;
-        args[i].finY = (i + 1) * filasPorHilo < nuevoAlto ? (i + 1) * filasPorHilo : nuevoAlto;
-
-        if (pthread_create(&hilos[i], NULL, rotarImagenHilo, &args[i]) != 0)
+        const double w = fabs(info->ancho * cosA) + fabs(info->alto * sinA);
+        const double h = fabs(info->ancho * sinA) + fabs(info->alto * cosA);
+        if (w > INT_MAX / 2 || h > INT_MAX / 2)
         {
-            fprintf(stderr, "Error al crear hilo %d\n", i);
-            liberarMatriz(nuevaMatriz, nuevoAlto, nuevoAncho);
-            return;
+            fprintf(stderr, "Imagen rotada demasiado grande\n");
+            return 0;
         }
+        // Se descuenta un margen mínimo para no sumar una columna por redondeo
+        nuevoAncho = (int)ceil(w - 1e-6);
+        nuevoAlto = (int)ceil(h - 1e-6);
     }
 
-    for (int i = 0; i < numHilos; i++)
+    IMG_INFO("Dimensiones: %dx%d → %dx%d\n", info->ancho, info->alto, nuevoAncho, nuevoAlto);
+
+    ImagenInfo rotada;
+    if (!crearImagen(&rotada, nuevoAncho, nuevoAlto, info->canales))
     {
-        pthread_join(hilos[i], NULL);
+        fprintf(stderr, "Error al asignar memoria para imagen rotada\n");
+        return 0;
     }
 
-    liberarMatriz(info->pixeles, info->alto, info->ancho);
-    info->pixeles = nuevaMatriz;
-    info->ancho = nuevoAncho;
-    info->alto = nuevoAlto;
+    numHilos = poolResolverHilos(numHilos);
+    RotacionArgs args;
+    memset(&args, 0, sizeof(args));
+    args.origen = info->pixeles;
+    args.destino = rotada.pixeles;
+    args.anchoOrigen = info->ancho;
+    args.altoOrigen = info->alto;
+    args.anchoDestino = nuevoAncho;
+    args.altoDestino = nuevoAlto;
+    args.canales = info->canales;
+    args.angulo = (float)normalizado;
+    args.cosAngulo = cosA;
+    args.sinAngulo = sinA;
+    args.centroXOrigen = (info->ancho - 1) / 2.0;
+    args.centroYOrigen = (info->alto - 1) / 2.0;
+    args.centroXDestino = (nuevoAncho - 1) / 2.0;
+    args.centroYDestino = (nuevoAlto - 1) / 2.0;
+    if (fondo)
+        memcpy(args.fondo, fondo, (size_t)info->canales);
+
+    // 90/270: teselas de una franja de bloques; resto: teselas de filas normales
+    int filasPorTesela = recto ? BLOQUE_ROTACION : poolFilasPorTesela((size_t)nuevoAncho * info->canales);
+    poolParaleloForTeselas(nuevoAlto, numHilos, filasPorTesela, rotarImagenRango, &args);
+
+    reemplazarImagen(info, &rotada);
 
-    printf("Imagen rotada exitosamente usando %d hilos (%s).\n", numHilos,
-           info->canales == 1 ? "grises" : "RGB");
+    IMG_INFO("Imagen rotada exitosamente usando %d hilos (%s).\n", numHilos,
+             info->canales == 1 ? "grises" : "RGB");
+    return 1;
 }
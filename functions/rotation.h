@@ -5,8 +5,8 @@
 
 typedef struct
 {
-    unsigned char ***origen;
-    unsigned char ***destino;
+    unsigned char **origen;
+    unsigned char **destino;
     int anchoOrigen;
     int altoOrigen;
     int anchoDestino;
@@ -15,20 +15,26 @@ typedef struct
     float angulo;
     int inicioY;
     int finY;
-    float cosAngulo;
-    float sinAngulo;
-    int centroXOrigen;
-    int centroYOrigen;
-    int centroXDestino;
-    int centroYDestino;
+    double cosAngulo;
+    double sinAngulo;
+    double centroXOrigen; // centros en coordenadas de píxel: (n - 1) / 2
+    double centroYOrigen;
+    double centroXDestino;
+    double centroYDestino;
+    unsigned char fondo[4]; // color de las zonas fuera del origen
 } RotacionArgs;
 
-void rotarImagenConcurrente(ImagenInfo *info, float angulo);
+// Rota la imagen angulo grados en sentido horario. Los múltiplos de 90 se
+// copian exactos; el resto se interpola (bilineal) sobre un lienzo ampliado
+// que contiene toda la imagen, con fondo negro en las esquinas.
+// numHilos <= 0 usa el número de hilos por defecto del pool
+// Devuelve 1 si la imagen se rotó, 0 si hubo error.
+int rotarImagenConcurrente(ImagenInfo *info, float angulo, int numHilos);
 
-void *rotarImagenHilo(void *args);
-
-unsigned char ***asignarMatriz(int alto, int ancho, int canales);
+// Igual que rotarImagenConcurrente con el color de fondo fondo (un valor por
+// canal; NULL = negro).
+int rotarImagenConFondo(ImagenInfo *info, float angulo, const unsigned char *fondo, int numHilos);
 
-void liberarMatriz(unsigned char ***matriz, int alto, int ancho);
+void *rotarImagenHilo(void *args);
 
 #endif // ROTATION_H
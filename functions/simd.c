@@ -0,0 +1,974 @@
+// Núcleos escalares y vectoriales con selección en tiempo de ejecución
+
+#include "simd.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#define SIMD_SSE2 __attribute__((target("sse2")))
+#define SIMD_AVX2 __attribute__((target("avx2")))
+// AVX-512 incluye FMA: sin fp-contract=off el compilador fusionaría mul + add
+// y el redondeo dejaría de coincidir con la versión escalar
+#define SIMD_AVX512 __attribute__((target("avx512f,avx512bw"), optimize("fp-contract=off")))
+#else
+#define SIMD_X86 0
+#endif
+
+// Tamaños de kernel 2D con versión propia de convolucionEnteraFila: con tam
+// constante el compilador desenrolla del todo los bucles de taps y deja los
+// pares de pesos en registros. Otros tamaños usan el cuerpo genérico.
+#define SIEMPRE_EN_LINEA inline __attribute__((always_inline))
+#define ESPECIALIZAR_CONVOLUCION_ENTERA(ATRIBUTOS, NIVEL)                                                      \
+    ATRIBUTOS static void convolucionEnteraFila##NIVEL(const unsigned char *const *filas, const int32_t *pares, \
+                                                       int tam, int canales, int desplazamiento,               \
+                                                       unsigned char *salida, size_t n)                        \
+    {                                                                                                          \
+        switch (tam)                                                                                           \
+        {                                                                                                      \
+        case 3:                                                                                                \
+            convolucionEntera##NIVEL(filas, pares, 3, canales, desplazamiento, salida, n);                     \
+            break;                                                                                             \
+        case 5:                                                                                                \
+            convolucionEntera##NIVEL(filas, pares, 5, canales, desplazamiento, salida, n);                     \
+            break;                                                                                             \
+        case 7:                                                                                                \
+            convolucionEntera##NIVEL(filas, pares, 7, canales, desplazamiento, salida, n);                     \
+            break;                                                                                             \
+        default:                                                                                               \
+            convolucionEntera##NIVEL(filas, pares, tam, canales, desplazamiento, salida, n);                   \
+            break;                                                                                             \
+        }                                                                                                      \
+    }
+
+// Pares de pesos que las versiones vectoriales copian a registros (7x7;
+// los bucles de carga llevan "#pragma GCC unroll 28" a juego)
+#define PARES_EN_REGISTROS (7 * 4)
+
+// ---------- Referencia escalar ----------
+
+static inline unsigned char redondearByte(float v)
+{
+    int r = (int)roundf(v);
+    return (unsigned char)(r < 0 ? 0 : (r > 255 ? 255 : r));
+}
+
+static inline int limitarDelta(int delta)
+{
+    return delta < -255 ? -255 : (delta > 255 ? 255 : delta);
+}
+
+static void brilloFilaEscalar(unsigned char *fila, size_t n, int delta)
+{
+    delta = limitarDelta(delta);
+    for (size_t i = 0; i < n; i++)
+    {
+        int nuevoValor = fila[i] + delta;
+        fila[i] = (unsigned char)(nuevoValor < 0 ? 0 : (nuevoValor > 255 ? 255 : nuevoValor));
+    }
+}
+
+static void convolucionHorizontalFilaEscalar(const unsigned char *fila, const float *kernel, int tam,
+                                             int canales, float *salida, size_t inicio, size_t fin)
+{
+    const ptrdiff_t centro = tam / 2;
+    for (size_t i = inicio; i < fin; i++)
+    {
+        const unsigned char *p = fila + i - centro * canales;
+        float suma = 0.0f;
+        for (int k = 0; k < tam; k++)
+            suma += p[(ptrdiff_t)k * canales] * kernel[k];
+        salida[i] = suma;
+    }
+}
+
+static void convolucionVerticalFilaEscalar(const float *const *filas, const float *kernel, int tam,
+                                           unsigned char *salida, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        float suma = 0.0f;
+        for (int k = 0; k < tam; k++)
+            suma += filas[k][i] * kernel[k];
+        salida[i] = redondearByte(suma);
+    }
+}
+
+// Salidas [inicio, fin) de convolucionEnteraFila (resto de las vectoriales)
+static SIEMPRE_EN_LINEA void convolucionEnteraTramo(const unsigned char *const *filas, const int32_t *pares,
+                                                    int tam, int canales, int desplazamiento,
+                                                    unsigned char *salida, size_t inicio, size_t fin)
+{
+    const int numPares = (tam + 1) / 2;
+    const int32_t redondeo = desplazamiento > 0 ? 1 << (desplazamiento - 1) : 0;
+    for (size_t i = inicio; i < fin; i++)
+    {
+        int32_t suma = redondeo;
+        for (int ky = 0; ky < tam; ky++)
+        {
+            const unsigned char *p = filas[ky] + i;
+            const int32_t *w = pares + (size_t)ky * numPares;
+            for (int kx = 0; kx + 1 < tam; kx += 2, p += 2 * canales)
+                suma += p[0] * (int16_t)(w[kx / 2] & 0xffff) + p[canales] * (int16_t)((uint32_t)w[kx / 2] >> 16);
+            if (tam % 2)
+                suma += p[0] * (int16_t)(w[tam / 2] & 0xffff);
+        }
+        suma >>= desplazamiento;
+        salida[i] = (unsigned char)(suma < 0 ? 0 : (suma > 255 ? 255 : suma));
+    }
+}
+
+static SIEMPRE_EN_LINEA void convolucionEnteraEscalar(const unsigned char *const *filas, const int32_t *pares,
+                                                      int tam, int canales, int desplazamiento,
+                                                      unsigned char *salida, size_t n)
+{
+    convolucionEnteraTramo(filas, pares, tam, canales, desplazamiento, salida, 0, n);
+}
+
+ESPECIALIZAR_CONVOLUCION_ENTERA(, Escalar)
+
+static void sobelPixelesEscalar(const unsigned char *a, const unsigned char *c, const unsigned char *b,
+                                unsigned char *salida, int desde, int hasta)
+{
+    for (int x = desde; x < hasta; x++)
+    {
+        int sx = (a[x + 1] - a[x - 1]) + 2 * (c[x + 1] - c[x - 1]) + (b[x + 1] - b[x - 1]);
+        int sy = (b[x - 1] + 2 * b[x] + b[x + 1]) - (a[x - 1] + 2 * a[x] + a[x + 1]);
+        int mag = (int)lround(sqrt((double)(sx * sx + sy * sy)));
+        salida[x] = (unsigned char)(mag > 255 ? 255 : mag);
+    }
+}
+
+static void sobelFilaEscalar(const unsigned char *arriba, const unsigned char *centro,
+                             const unsigned char *abajo, unsigned char *salida, int ancho)
+{
+    sobelPixelesEscalar(arriba, centro, abajo, salida, 1, ancho - 1);
+}
+
+// Mezcla 8.8: las dos mezclas en X dan valores * 256 y la mezcla en Y
+// los lleva a * 65536; se redondea sumando la mitad antes de desplazar
+static inline unsigned char mezclaBilineal(int top, int bottom, int wy)
+{
+    return (unsigned char)(((top << 8) + (bottom - top) * wy + 32768) >> 16);
+}
+
+static void resizeBilinealFilaEscalar(const unsigned char *f0, const unsigned char *f1, int wy,
+                                      const int *offset0, const int *offset1, const int *pesosX,
+                                      int canales, size_t bytesFila, unsigned char *salida,
+                                      int xInicio, int xFin)
+{
+    (void)bytesFila;
+    for (int x = xInicio; x < xFin; x++)
+    {
+        const int o0 = offset0[x];
+        const int o1 = offset1[x];
+        const int wx0 = pesosX[x] & 0xFFFF;
+        const int wx1 = pesosX[x] >> 16;
+
+        for (int c = 0; c < canales; c++)
+        {
+            // Interpolación bilineal: mezcla en X y luego en Y
+            int top = f0[o0 + c] * wx0 + f0[o1 + c] * wx1;
+            int bottom = f1[o0 + c] * wx0 + f1[o1 + c] * wx1;
+            salida[(size_t)x * canales + c] = mezclaBilineal(top, bottom, wy);
+        }
+    }
+}
+
+static void transponer8x8Escalar(const unsigned char *const *origen, unsigned char *const *destino)
+{
+    for (int i = 0; i < 8; i++)
+        for (int j = 0; j < 8; j++)
+            destino[i][j] = origen[j][i];
+}
+
+static void lutFilaEscalar(unsigned char *fila, size_t n, const unsigned char *tabla, int canales)
+{
+    if (canales == 1)
+    {
+        for (size_t i = 0; i < n; i++)
+            fila[i] = tabla[fila[i]];
+        return;
+    }
+    size_t i = 0;
+    for (; i + canales <= n; i += canales)
+        for (int c = 0; c < canales; c++)
+            fila[i + c] = tabla[c * 256 + fila[i + c]];
+    for (int c = 0; i < n; i++, c++)
+        fila[i] = tabla[c * 256 + fila[i]];
+}
+
+static void recursivoFilaEscalar(const float *entrada, const double *s1, const double *s2, double *s3,
+                                 const double *coef, float *salida, size_t n)
+{
+    for (size_t j = 0; j < n; j++)
+    {
+        double w = coef[0] * entrada[j] + coef[1] * s1[j] + coef[2] * s2[j] + coef[3] * s3[j];
+        s3[j] = w;
+        salida[j] = (float)w;
+    }
+}
+
+#if SIMD_X86
+
+// ---------- SSE2 ----------
+
+SIMD_SSE2 static void brilloFilaSse2(unsigned char *fila, size_t n, int delta)
+{
+    delta = limitarDelta(delta);
+    const __m128i d = _mm_set1_epi8((char)(delta < 0 ? -delta : delta));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(fila + i));
+        v = delta < 0 ? _mm_subs_epu8(v, d) : _mm_adds_epu8(v, d);
+        _mm_storeu_si128((__m128i *)(fila + i), v);
+    }
+    brilloFilaEscalar(fila + i, n - i, delta);
+}
+
+SIMD_SSE2 static inline __m128 cargar4BytesSse2(const unsigned char *p)
+{
+    int v;
+    memcpy(&v, p, 4);
+    const __m128i cero = _mm_setzero_si128();
+    __m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), cero);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(b, cero));
+}
+
+SIMD_SSE2 static void convolucionHorizontalFilaSse2(const unsigned char *fila, const float *kernel, int tam,
+                                                    int canales, float *salida, size_t inicio, size_t fin)
+{
+    const ptrdiff_t centro = tam / 2;
+    size_t i = inicio;
+    for (; i + 4 <= fin; i += 4)
+    {
+        const unsigned char *p = fila + i - centro * canales;
+        __m128 suma = _mm_setzero_ps();
+        for (int k = 0; k < tam; k++)
+            suma = _mm_add_ps(suma, _mm_mul_ps(cargar4BytesSse2(p + (ptrdiff_t)k * canales), _mm_set1_ps(kernel[k])));
+        _mm_storeu_ps(salida + i, suma);
+    }
+    convolucionHorizontalFilaEscalar(fila, kernel, tam, canales, salida, i, fin);
+}
+
+// round() + clamp [0, 255] para 4 floats: trunc(x) + (frac(x) >= 0.5)
+SIMD_SSE2 static inline __m128i redondearSse2(__m128 v)
+{
+    v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    __m128i t = _mm_cvttps_epi32(v);
+    __m128 frac = _mm_sub_ps(v, _mm_cvtepi32_ps(t));
+    return _mm_sub_epi32(t, _mm_castps_si128(_mm_cmpge_ps(frac, _mm_set1_ps(0.5f))));
+}
+
+SIMD_SSE2 static void convolucionVerticalFilaSse2(const float *const *filas, const float *kernel, int tam,
+                                                  unsigned char *salida, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 suma = _mm_setzero_ps();
+        for (int k = 0; k < tam; k++)
+            suma = _mm_add_ps(suma, _mm_mul_ps(_mm_loadu_ps(filas[k] + i), _mm_set1_ps(kernel[k])));
+        __m128i r = redondearSse2(suma);
+        r = _mm_packs_epi32(r, r);
+        r = _mm_packus_epi16(r, r);
+        int v = _mm_cvtsi128_si32(r);
+        memcpy(salida + i, &v, 4);
+    }
+    for (; i < n; i++)
+    {
+        float suma = 0.0f;
+        for (int k = 0; k < tam; k++)
+            suma += filas[k][i] * kernel[k];
+        salida[i] = redondearByte(suma);
+    }
+}
+
+// Cada par de taps (a, b) se intercala byte a byte y se extiende a palabras:
+// pmaddwd con el par de pesos da a * wa + b * wb por salida en int32. Un
+// tap impar final repite el píxel a con peso 0 (no lee fuera de la fila).
+SIMD_SSE2 static SIEMPRE_EN_LINEA void convolucionEnteraSse2(const unsigned char *const *filas,
+                                                             const int32_t *pares, int tam, int canales,
+                                                             int desplazamiento, unsigned char *salida, size_t n)
+{
+    const int numPares = (tam + 1) / 2;
+    // Con tam constante (<= 7) los pares difundidos quedan en registros;
+    // activos marca los pares con algún peso (el realce tiene 4 de 9 a 0)
+    __m128i pesos[PARES_EN_REGISTROS];
+    uint32_t activos = 0;
+    const int enRegistros = tam * numPares <= PARES_EN_REGISTROS;
+    if (enRegistros)
+    {
+#pragma GCC unroll 28
+        for (int k = 0; k < tam * numPares; k++)
+        {
+            pesos[k] = _mm_set1_epi32(pares[k]);
+            activos |= (uint32_t)(pares[k] != 0) << k;
+        }
+    }
+    const __m128i redondeo = _mm_set1_epi32(desplazamiento > 0 ? 1 << (desplazamiento - 1) : 0);
+    const __m128i cuenta = _mm_cvtsi32_si128(desplazamiento);
+    const __m128i cero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i s0 = redondeo, s1 = redondeo, s2 = redondeo, s3 = redondeo;
+#pragma GCC unroll 7
+        for (int ky = 0; ky < tam; ky++)
+        {
+            const unsigned char *p = filas[ky] + i;
+            const int32_t *w = pares + (size_t)ky * numPares;
+#pragma GCC unroll 4
+            for (int j = 0; j < numPares; j++)
+            {
+                if (enRegistros ? !(activos >> (ky * numPares + j) & 1) : w[j] == 0)
+                    continue;
+                const ptrdiff_t da = (ptrdiff_t)2 * j * canales;
+                const ptrdiff_t db = 2 * j + 1 < tam ? da + canales : da;
+                __m128i a = _mm_loadu_si128((const __m128i *)(p + da));
+                __m128i b = _mm_loadu_si128((const __m128i *)(p + db));
+                __m128i peso = enRegistros ? pesos[ky * numPares + j] : _mm_set1_epi32(w[j]);
+                __m128i lo = _mm_unpacklo_epi8(a, b), hi = _mm_unpackhi_epi8(a, b);
+                s0 = _mm_add_epi32(s0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, cero), peso));
+                s1 = _mm_add_epi32(s1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, cero), peso));
+                s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, cero), peso));
+                s3 = _mm_add_epi32(s3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, cero), peso));
+            }
+        }
+        // Las saturaciones de packs/packus equivalen al clamp [0, 255]
+        __m128i r01 = _mm_packs_epi32(_mm_sra_epi32(s0, cuenta), _mm_sra_epi32(s1, cuenta));
+        __m128i r23 = _mm_packs_epi32(_mm_sra_epi32(s2, cuenta), _mm_sra_epi32(s3, cuenta));
+        _mm_storeu_si128((__m128i *)(salida + i), _mm_packus_epi16(r01, r23));
+    }
+    convolucionEnteraTramo(filas, pares, tam, canales, desplazamiento, salida, i, n);
+}
+
+ESPECIALIZAR_CONVOLUCION_ENTERA(SIMD_SSE2, Sse2)
+
+SIMD_SSE2 static inline __m128i cargar8Sse2(const unsigned char *p)
+{
+    return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p), _mm_setzero_si128());
+}
+
+// Magnitud redondeada de 8 gradientes (int16) -> 8 bytes saturados
+SIMD_SSE2 static inline __m128i magnitudSse2(__m128i gx, __m128i gy)
+{
+    __m128i lo = _mm_unpacklo_epi16(gx, gy);
+    __m128i hi = _mm_unpackhi_epi16(gx, gy);
+    __m128i mlo = _mm_cvtps_epi32(_mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(lo, lo))));
+    __m128i mhi = _mm_cvtps_epi32(_mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(hi, hi))));
+    __m128i w = _mm_packs_epi32(mlo, mhi);
+    return _mm_packus_epi16(w, w);
+}
+
+SIMD_SSE2 static void sobelFilaSse2(const unsigned char *arriba, const unsigned char *centro,
+                                    const unsigned char *abajo, unsigned char *salida, int ancho)
+{
+    int x = 1;
+    for (; x + 9 <= ancho; x += 8)
+    {
+        __m128i a0 = cargar8Sse2(arriba + x - 1), a1 = cargar8Sse2(arriba + x), a2 = cargar8Sse2(arriba + x + 1);
+        __m128i c0 = cargar8Sse2(centro + x - 1), c2 = cargar8Sse2(centro + x + 1);
+        __m128i b0 = cargar8Sse2(abajo + x - 1), b1 = cargar8Sse2(abajo + x), b2 = cargar8Sse2(abajo + x + 1);
+
+        __m128i gx = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(a2, a0), _mm_slli_epi16(_mm_sub_epi16(c2, c0), 1)),
+                                   _mm_sub_epi16(b2, b0));
+        __m128i gy = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(b0, _mm_slli_epi16(b1, 1)), b2),
+                                   _mm_add_epi16(_mm_add_epi16(a0, _mm_slli_epi16(a1, 1)), a2));
+        _mm_storel_epi64((__m128i *)(salida + x), magnitudSse2(gx, gy));
+    }
+    sobelPixelesEscalar(arriba, centro, abajo, salida, x, ancho - 1);
+}
+
+SIMD_SSE2 static void transponer8x8Sse2(const unsigned char *const *origen, unsigned char *const *destino)
+{
+    __m128i f[8];
+    for (int j = 0; j < 8; j++)
+        f[j] = _mm_loadl_epi64((const __m128i *)origen[j]);
+
+    // Intercalar bytes, palabras y dobles palabras: cada registro final tiene
+    // dos columnas de 8 bytes
+    __m128i t0 = _mm_unpacklo_epi8(f[0], f[1]);
+    __m128i t1 = _mm_unpacklo_epi8(f[2], f[3]);
+    __m128i t2 = _mm_unpacklo_epi8(f[4], f[5]);
+    __m128i t3 = _mm_unpacklo_epi8(f[6], f[7]);
+    __m128i u0 = _mm_unpacklo_epi16(t0, t1);
+    __m128i u1 = _mm_unpackhi_epi16(t0, t1);
+    __m128i u2 = _mm_unpacklo_epi16(t2, t3);
+    __m128i u3 = _mm_unpackhi_epi16(t2, t3);
+    __m128i c[4] = {_mm_unpacklo_epi32(u0, u2), _mm_unpackhi_epi32(u0, u2),
+                    _mm_unpacklo_epi32(u1, u3), _mm_unpackhi_epi32(u1, u3)};
+
+    for (int k = 0; k < 4; k++)
+    {
+        _mm_storel_epi64((__m128i *)destino[2 * k], c[k]);
+        _mm_storel_epi64((__m128i *)destino[2 * k + 1], _mm_unpackhi_epi64(c[k], c[k]));
+    }
+}
+
+SIMD_SSE2 static void recursivoFilaSse2(const float *entrada, const double *s1, const double *s2, double *s3,
+                                        const double *coef, float *salida, size_t n)
+{
+    const __m128d c0 = _mm_set1_pd(coef[0]), c1 = _mm_set1_pd(coef[1]);
+    const __m128d c2 = _mm_set1_pd(coef[2]), c3 = _mm_set1_pd(coef[3]);
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4)
+    {
+        const __m128 x = _mm_loadu_ps(entrada + j);
+        __m128d w[2];
+        for (int k = 0; k < 2; k++)
+        {
+            // Mitad baja y alta de los 4 floats
+            __m128d xd = _mm_cvtps_pd(k == 0 ? x : _mm_movehl_ps(x, x));
+            __m128d v = _mm_add_pd(_mm_mul_pd(c0, xd), _mm_mul_pd(c1, _mm_loadu_pd(s1 + j + 2 * k)));
+            v = _mm_add_pd(v, _mm_mul_pd(c2, _mm_loadu_pd(s2 + j + 2 * k)));
+            w[k] = _mm_add_pd(v, _mm_mul_pd(c3, _mm_loadu_pd(s3 + j + 2 * k)));
+            _mm_storeu_pd(s3 + j + 2 * k, w[k]);
+        }
+        _mm_storeu_ps(salida + j, _mm_movelh_ps(_mm_cvtpd_ps(w[0]), _mm_cvtpd_ps(w[1])));
+    }
+    recursivoFilaEscalar(entrada + j, s1 + j, s2 + j, s3 + j, coef, salida + j, n - j);
+}
+
+// ---------- AVX2 ----------
+
+SIMD_AVX2 static void brilloFilaAvx2(unsigned char *fila, size_t n, int delta)
+{
+    delta = limitarDelta(delta);
+    const __m256i d = _mm256_set1_epi8((char)(delta < 0 ? -delta : delta));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(fila + i));
+        v = delta < 0 ? _mm256_subs_epu8(v, d) : _mm256_adds_epu8(v, d);
+        _mm256_storeu_si256((__m256i *)(fila + i), v);
+    }
+    brilloFilaEscalar(fila + i, n - i, delta);
+}
+
+SIMD_AVX2 static void convolucionHorizontalFilaAvx2(const unsigned char *fila, const float *kernel, int tam,
+                                                    int canales, float *salida, size_t inicio, size_t fin)
+{
+    const ptrdiff_t centro = tam / 2;
+    size_t i = inicio;
+    for (; i + 8 <= fin; i += 8)
+    {
+        const unsigned char *p = fila + i - centro * canales;
+        __m256 suma = _mm256_setzero_ps();
+        for (int k = 0; k < tam; k++)
+        {
+            __m128i bytes = _mm_loadl_epi64((const __m128i *)(p + (ptrdiff_t)k * canales));
+            __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+            suma = _mm256_add_ps(suma, _mm256_mul_ps(v, _mm256_set1_ps(kernel[k])));
+        }
+        _mm256_storeu_ps(salida + i, suma);
+    }
+    convolucionHorizontalFilaEscalar(fila, kernel, tam, canales, salida, i, fin);
+}
+
+// round() + clamp [0, 255] para 8 floats
+SIMD_AVX2 static inline __m256i redondearAvx2(__m256 v)
+{
+    v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+    __m256i t = _mm256_cvttps_epi32(v);
+    __m256 frac = _mm256_sub_ps(v, _mm256_cvtepi32_ps(t));
+    return _mm256_sub_epi32(t, _mm256_castps_si256(_mm256_cmp_ps(frac, _mm256_set1_ps(0.5f), _CMP_GE_OQ)));
+}
+
+// 8 enteros en [0, 255] -> 8 bytes en salida
+SIMD_AVX2 static inline void guardar8BytesAvx2(unsigned char *salida, __m256i r)
+{
+    __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1));
+    _mm_storel_epi64((__m128i *)salida, _mm_packus_epi16(w, w));
+}
+
+SIMD_AVX2 static void convolucionVerticalFilaAvx2(const float *const *filas, const float *kernel, int tam,
+                                                  unsigned char *salida, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 suma = _mm256_setzero_ps();
+        for (int k = 0; k < tam; k++)
+            suma = _mm256_add_ps(suma, _mm256_mul_ps(_mm256_loadu_ps(filas[k] + i), _mm256_set1_ps(kernel[k])));
+        guardar8BytesAvx2(salida + i, redondearAvx2(suma));
+    }
+    for (; i < n; i++)
+    {
+        float suma = 0.0f;
+        for (int k = 0; k < tam; k++)
+            suma += filas[k][i] * kernel[k];
+        salida[i] = redondearByte(suma);
+    }
+}
+
+SIMD_AVX2 static inline __m256i cargar16Avx2(const unsigned char *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+// Como la SSE2 con 32 salidas: los unpack trabajan por carriles de 128 bits,
+// pero packs/packus deshacen el mismo cruce y el orden final es el lineal
+SIMD_AVX2 static SIEMPRE_EN_LINEA void convolucionEnteraAvx2(const unsigned char *const *filas,
+                                                             const int32_t *pares, int tam, int canales,
+                                                             int desplazamiento, unsigned char *salida, size_t n)
+{
+    const int numPares = (tam + 1) / 2;
+    // Con tam constante (<= 7) los pares difundidos quedan en registros;
+    // activos marca los pares con algún peso (el realce tiene 4 de 9 a 0)
+    __m256i pesos[PARES_EN_REGISTROS];
+    uint32_t activos = 0;
+    const int enRegistros = tam * numPares <= PARES_EN_REGISTROS;
+    if (enRegistros)
+    {
+#pragma GCC unroll 28
+        for (int k = 0; k < tam * numPares; k++)
+        {
+            pesos[k] = _mm256_set1_epi32(pares[k]);
+            activos |= (uint32_t)(pares[k] != 0) << k;
+        }
+    }
+    const __m256i redondeo = _mm256_set1_epi32(desplazamiento > 0 ? 1 << (desplazamiento - 1) : 0);
+    const __m128i cuenta = _mm_cvtsi32_si128(desplazamiento);
+    const __m256i cero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i s0 = redondeo, s1 = redondeo, s2 = redondeo, s3 = redondeo;
+#pragma GCC unroll 7
+        for (int ky = 0; ky < tam; ky++)
+        {
+            const unsigned char *p = filas[ky] + i;
+            const int32_t *w = pares + (size_t)ky * numPares;
+#pragma GCC unroll 4
+            for (int j = 0; j < numPares; j++)
+            {
+                if (enRegistros ? !(activos >> (ky * numPares + j) & 1) : w[j] == 0)
+                    continue;
+                const ptrdiff_t da = (ptrdiff_t)2 * j * canales;
+                const ptrdiff_t db = 2 * j + 1 < tam ? da + canales : da;
+                __m256i a = _mm256_loadu_si256((const __m256i *)(p + da));
+                __m256i b = _mm256_loadu_si256((const __m256i *)(p + db));
+                __m256i peso = enRegistros ? pesos[ky * numPares + j] : _mm256_set1_epi32(w[j]);
+                __m256i lo = _mm256_unpacklo_epi8(a, b), hi = _mm256_unpackhi_epi8(a, b);
+                s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, cero), peso));
+                s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, cero), peso));
+                s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, cero), peso));
+                s3 = _mm256_add_epi32(s3, _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, cero), peso));
+            }
+        }
+        __m256i r01 = _mm256_packs_epi32(_mm256_sra_epi32(s0, cuenta), _mm256_sra_epi32(s1, cuenta));
+        __m256i r23 = _mm256_packs_epi32(_mm256_sra_epi32(s2, cuenta), _mm256_sra_epi32(s3, cuenta));
+        _mm256_storeu_si256((__m256i *)(salida + i), _mm256_packus_epi16(r01, r23));
+    }
+    convolucionEnteraTramo(filas, pares, tam, canales, desplazamiento, salida, i, n);
+}
+
+ESPECIALIZAR_CONVOLUCION_ENTERA(SIMD_AVX2, Avx2)
+
+SIMD_AVX2 static void sobelFilaAvx2(const unsigned char *arriba, const unsigned char *centro,
+                                    const unsigned char *abajo, unsigned char *salida, int ancho)
+{
+    int x = 1;
+    for (; x + 17 <= ancho; x += 16)
+    {
+        __m256i a0 = cargar16Avx2(arriba + x - 1), a1 = cargar16Avx2(arriba + x), a2 = cargar16Avx2(arriba + x + 1);
+        __m256i c0 = cargar16Avx2(centro + x - 1), c2 = cargar16Avx2(centro + x + 1);
+        __m256i b0 = cargar16Avx2(abajo + x - 1), b1 = cargar16Avx2(abajo + x), b2 = cargar16Avx2(abajo + x + 1);
+
+        __m256i gx = _mm256_add_epi16(_mm256_add_epi16(_mm256_sub_epi16(a2, a0),
+                                                       _mm256_slli_epi16(_mm256_sub_epi16(c2, c0), 1)),
+                                      _mm256_sub_epi16(b2, b0));
+        __m256i gy = _mm256_sub_epi16(_mm256_add_epi16(_mm256_add_epi16(b0, _mm256_slli_epi16(b1, 1)), b2),
+                                      _mm256_add_epi16(_mm256_add_epi16(a0, _mm256_slli_epi16(a1, 1)), a2));
+
+        // gx^2 + gy^2 en int32 con madd sobre pares (gx, gy)
+        __m256i lo = _mm256_unpacklo_epi16(gx, gy);
+        __m256i hi = _mm256_unpackhi_epi16(gx, gy);
+        __m256i mlo = _mm256_cvtps_epi32(_mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(lo, lo))));
+        __m256i mhi = _mm256_cvtps_epi32(_mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(hi, hi))));
+
+        // Los unpack/pack trabajan por mitades de 128 bits: al empaquetar
+        // quedan en orden los píxeles 0-7 y 8-15 en cada mitad
+        __m256i w = _mm256_packs_epi32(mlo, mhi);
+        __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(w, w), 0x08);
+        _mm_storeu_si128((__m128i *)(salida + x), _mm256_castsi256_si128(b));
+    }
+    sobelPixelesEscalar(arriba, centro, abajo, salida, x, ancho - 1);
+}
+
+SIMD_AVX2 static void resizeBilinealFilaAvx2(const unsigned char *f0, const unsigned char *f1, int wy,
+                                             const int *offset0, const int *offset1, const int *pesosX,
+                                             int canales, size_t bytesFila, unsigned char *salida,
+                                             int xInicio, int xFin)
+{
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+    const __m256i vWy = _mm256_set1_epi32(wy);
+    const __m256i mitad = _mm256_set1_epi32(32768);
+    int x = xInicio;
+
+    for (; x + 8 <= xFin; x += 8)
+    {
+        // Cada gather lee 4 bytes (todos los canales de un píxel): deben caer
+        // dentro de la fila; los offsets crecen con x, basta el último
+        if ((size_t)offset1[x + 7] + 3 >= bytesFila)
+            break;
+
+        __m256i o0 = _mm256_loadu_si256((const __m256i *)(offset0 + x));
+        __m256i o1 = _mm256_loadu_si256((const __m256i *)(offset1 + x));
+        __m256i pesos = _mm256_loadu_si256((const __m256i *)(pesosX + x));
+        __m256i a0 = _mm256_i32gather_epi32((const int *)f0, o0, 1);
+        __m256i a1 = _mm256_i32gather_epi32((const int *)f0, o1, 1);
+        __m256i b0 = _mm256_i32gather_epi32((const int *)f1, o0, 1);
+        __m256i b1 = _mm256_i32gather_epi32((const int *)f1, o1, 1);
+
+        for (int c = 0; c < canales; c++)
+        {
+            // Pares (p(x0), p(x1)) en 16 bits: madd con (256 - wx, wx) hace la
+            // mezcla en X de cada fila en una instrucción
+            __m256i paresA = _mm256_or_si256(_mm256_and_si256(a0, byte), _mm256_slli_epi32(_mm256_and_si256(a1, byte), 16));
+            __m256i paresB = _mm256_or_si256(_mm256_and_si256(b0, byte), _mm256_slli_epi32(_mm256_and_si256(b1, byte), 16));
+            __m256i top = _mm256_madd_epi16(paresA, pesos);
+            __m256i bottom = _mm256_madd_epi16(paresB, pesos);
+            __m256i v = _mm256_add_epi32(_mm256_slli_epi32(top, 8), _mm256_mullo_epi32(_mm256_sub_epi32(bottom, top), vWy));
+            __m256i r = _mm256_srli_epi32(_mm256_add_epi32(v, mitad), 16);
+
+            if (canales == 1)
+            {
+                guardar8BytesAvx2(salida + x, r);
+            }
+            else
+            {
+                int valores[8];
+                _mm256_storeu_si256((__m256i *)valores, r);
+                for (int l = 0; l < 8; l++)
+                    salida[(size_t)(x + l) * canales + c] = (unsigned char)valores[l];
+            }
+
+            // Siguiente canal al byte bajo
+            a0 = _mm256_srli_epi32(a0, 8);
+            a1 = _mm256_srli_epi32(a1, 8);
+            b0 = _mm256_srli_epi32(b0, 8);
+            b1 = _mm256_srli_epi32(b1, 8);
+        }
+    }
+    resizeBilinealFilaEscalar(f0, f1, wy, offset0, offset1, pesosX, canales, bytesFila, salida, x, xFin);
+}
+
+// Desplazamientos de tabla por carril para un grupo de 8 bytes que empieza en
+// un byte de canal r: ((r + carril) % canales) * 256
+SIMD_AVX2 static void desplazamientosLutAvx2(int canales, __m256i *desp)
+{
+    for (int r = 0; r < canales; r++)
+    {
+        int d[8];
+        for (int k = 0; k < 8; k++)
+            d[k] = ((r + k) % canales) * 256;
+        desp[r] = _mm256_loadu_si256((const __m256i *)d);
+    }
+}
+
+SIMD_AVX2 static void lutFilaAvx2(unsigned char *fila, size_t n, const unsigned char *tabla, int canales)
+{
+    __m256i desp[4];
+    desplazamientosLutAvx2(canales, desp);
+    const __m256i mascara = _mm256_set1_epi32(0xFF);
+    const __m256i orden = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    int r = 0; // canal del primer byte del grupo
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i g[4];
+        for (int k = 0; k < 4; k++)
+        {
+            __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(fila + i + 8 * k)));
+            idx = _mm256_add_epi32(idx, desp[r]);
+            g[k] = _mm256_and_si256(_mm256_i32gather_epi32((const int *)tabla, idx, 1), mascara);
+            r = (r + 8) % canales;
+        }
+        // 4 x 8 dwords -> 32 bytes: los pack trabajan por carriles de 128 bits
+        __m256i ab = _mm256_packus_epi32(g[0], g[1]);
+        __m256i cd = _mm256_packus_epi32(g[2], g[3]);
+        __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(ab, cd), orden);
+        _mm256_storeu_si256((__m256i *)(fila + i), bytes);
+    }
+    // El resto empieza en el canal r
+    for (; i < n; i++, r = (r + 1) % canales)
+        fila[i] = tabla[r * 256 + fila[i]];
+}
+
+SIMD_AVX2 static void recursivoFilaAvx2(const float *entrada, const double *s1, const double *s2, double *s3,
+                                        const double *coef, float *salida, size_t n)
+{
+    const __m256d c0 = _mm256_set1_pd(coef[0]), c1 = _mm256_set1_pd(coef[1]);
+    const __m256d c2 = _mm256_set1_pd(coef[2]), c3 = _mm256_set1_pd(coef[3]);
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4)
+    {
+        __m256d x = _mm256_cvtps_pd(_mm_loadu_ps(entrada + j));
+        __m256d v = _mm256_add_pd(_mm256_mul_pd(c0, x), _mm256_mul_pd(c1, _mm256_loadu_pd(s1 + j)));
+        v = _mm256_add_pd(v, _mm256_mul_pd(c2, _mm256_loadu_pd(s2 + j)));
+        v = _mm256_add_pd(v, _mm256_mul_pd(c3, _mm256_loadu_pd(s3 + j)));
+        _mm256_storeu_pd(s3 + j, v);
+        _mm_storeu_ps(salida + j, _mm256_cvtpd_ps(v));
+    }
+    recursivoFilaEscalar(entrada + j, s1 + j, s2 + j, s3 + j, coef, salida + j, n - j);
+}
+
+// ---------- AVX-512 ----------
+
+SIMD_AVX512 static void brilloFilaAvx512(unsigned char *fila, size_t n, int delta)
+{
+    delta = limitarDelta(delta);
+    const __m512i d = _mm512_set1_epi8((char)(delta < 0 ? -delta : delta));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64)
+    {
+        __m512i v = _mm512_loadu_si512((const void *)(fila + i));
+        v = delta < 0 ? _mm512_subs_epu8(v, d) : _mm512_adds_epu8(v, d);
+        _mm512_storeu_si512((void *)(fila + i), v);
+    }
+    brilloFilaEscalar(fila + i, n - i, delta);
+}
+
+SIMD_AVX512 static void convolucionHorizontalFilaAvx512(const unsigned char *fila, const float *kernel, int tam,
+                                                        int canales, float *salida, size_t inicio, size_t fin)
+{
+    const ptrdiff_t centro = tam / 2;
+    size_t i = inicio;
+    for (; i + 16 <= fin; i += 16)
+    {
+        const unsigned char *p = fila + i - centro * canales;
+        __m512 suma = _mm512_setzero_ps();
+        for (int k = 0; k < tam; k++)
+        {
+            __m128i bytes = _mm_loadu_si128((const __m128i *)(p + (ptrdiff_t)k * canales));
+            __m512 v = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(bytes));
+            suma = _mm512_add_ps(suma, _mm512_mul_ps(v, _mm512_set1_ps(kernel[k])));
+        }
+        _mm512_storeu_ps(salida + i, suma);
+    }
+    convolucionHorizontalFilaEscalar(fila, kernel, tam, canales, salida, i, fin);
+}
+
+SIMD_AVX512 static void convolucionVerticalFilaAvx512(const float *const *filas, const float *kernel, int tam,
+                                                      unsigned char *salida, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512 suma = _mm512_setzero_ps();
+        for (int k = 0; k < tam; k++)
+            suma = _mm512_add_ps(suma, _mm512_mul_ps(_mm512_loadu_ps(filas[k] + i), _mm512_set1_ps(kernel[k])));
+
+        // round() + clamp [0, 255]
+        __m512 v = _mm512_min_ps(_mm512_max_ps(suma, _mm512_setzero_ps()), _mm512_set1_ps(255.0f));
+        __m512i t = _mm512_cvttps_epi32(v);
+        __m512 frac = _mm512_sub_ps(v, _mm512_cvtepi32_ps(t));
+        __mmask16 mitad = _mm512_cmp_ps_mask(frac, _mm512_set1_ps(0.5f), _CMP_GE_OQ);
+        t = _mm512_mask_add_epi32(t, mitad, t, _mm512_set1_epi32(1));
+        _mm_storeu_si128((__m128i *)(salida + i), _mm512_cvtepi32_epi8(t));
+    }
+    for (; i < n; i++)
+    {
+        float suma = 0.0f;
+        for (int k = 0; k < tam; k++)
+            suma += filas[k][i] * kernel[k];
+        salida[i] = redondearByte(suma);
+    }
+}
+
+// Como la AVX2 con 64 salidas
+SIMD_AVX512 static SIEMPRE_EN_LINEA void convolucionEnteraAvx512(const unsigned char *const *filas,
+                                                                 const int32_t *pares, int tam, int canales,
+                                                                 int desplazamiento, unsigned char *salida, size_t n)
+{
+    const int numPares = (tam + 1) / 2;
+    // Con tam constante (<= 7) los pares difundidos quedan en registros;
+    // activos marca los pares con algún peso (el realce tiene 4 de 9 a 0)
+    __m512i pesos[PARES_EN_REGISTROS];
+    uint32_t activos = 0;
+    const int enRegistros = tam * numPares <= PARES_EN_REGISTROS;
+    if (enRegistros)
+    {
+#pragma GCC unroll 28
+        for (int k = 0; k < tam * numPares; k++)
+        {
+            pesos[k] = _mm512_set1_epi32(pares[k]);
+            activos |= (uint32_t)(pares[k] != 0) << k;
+        }
+    }
+    const __m512i redondeo = _mm512_set1_epi32(desplazamiento > 0 ? 1 << (desplazamiento - 1) : 0);
+    const __m128i cuenta = _mm_cvtsi32_si128(desplazamiento);
+    const __m512i cero = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64)
+    {
+        __m512i s0 = redondeo, s1 = redondeo, s2 = redondeo, s3 = redondeo;
+#pragma GCC unroll 7
+        for (int ky = 0; ky < tam; ky++)
+        {
+            const unsigned char *p = filas[ky] + i;
+            const int32_t *w = pares + (size_t)ky * numPares;
+#pragma GCC unroll 4
+            for (int j = 0; j < numPares; j++)
+            {
+                if (enRegistros ? !(activos >> (ky * numPares + j) & 1) : w[j] == 0)
+                    continue;
+                const ptrdiff_t da = (ptrdiff_t)2 * j * canales;
+                const ptrdiff_t db = 2 * j + 1 < tam ? da + canales : da;
+                __m512i a = _mm512_loadu_si512((const __m512i *)(p + da));
+                __m512i b = _mm512_loadu_si512((const __m512i *)(p + db));
+                __m512i peso = enRegistros ? pesos[ky * numPares + j] : _mm512_set1_epi32(w[j]);
+                __m512i lo = _mm512_unpacklo_epi8(a, b), hi = _mm512_unpackhi_epi8(a, b);
+                s0 = _mm512_add_epi32(s0, _mm512_madd_epi16(_mm512_unpacklo_epi8(lo, cero), peso));
+                s1 = _mm512_add_epi32(s1, _mm512_madd_epi16(_mm512_unpackhi_epi8(lo, cero), peso));
+                s2 = _mm512_add_epi32(s2, _mm512_madd_epi16(_mm512_unpacklo_epi8(hi, cero), peso));
+                s3 = _mm512_add_epi32(s3, _mm512_madd_epi16(_mm512_unpackhi_epi8(hi, cero), peso));
+            }
+        }
+        __m512i r01 = _mm512_packs_epi32(_mm512_sra_epi32(s0, cuenta), _mm512_sra_epi32(s1, cuenta));
+        __m512i r23 = _mm512_packs_epi32(_mm512_sra_epi32(s2, cuenta), _mm512_sra_epi32(s3, cuenta));
+        _mm512_storeu_si512((__m512i *)(salida + i), _mm512_packus_epi16(r01, r23));
+    }
+    convolucionEnteraTramo(filas, pares, tam, canales, desplazamiento, salida, i, n);
+}
+
+ESPECIALIZAR_CONVOLUCION_ENTERA(SIMD_AVX512, Avx512)
+
+SIMD_AVX512 static void lutFilaAvx512(unsigned char *fila, size_t n, const unsigned char *tabla, int canales)
+{
+    __m512i desp[4];
+    for (int r = 0; r < canales; r++)
+    {
+        int d[16];
+        for (int k = 0; k < 16; k++)
+            d[k] = ((r + k) % canales) * 256;
+        desp[r] = _mm512_loadu_si512((const void *)d);
+    }
+    size_t i = 0;
+    int r = 0; // canal del primer byte del grupo
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512i idx = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)(fila + i)));
+        idx = _mm512_add_epi32(idx, desp[r]);
+        // vpmovdb se queda con el byte bajo de cada entrada leída
+        __m512i v = _mm512_i32gather_epi32(idx, (const void *)tabla, 1);
+        _mm_storeu_si128((__m128i *)(fila + i), _mm512_cvtepi32_epi8(v));
+        r = (r + 16) % canales;
+    }
+    for (; i < n; i++, r = (r + 1) % canales)
+        fila[i] = tabla[r * 256 + fila[i]];
+}
+
+SIMD_AVX512 static void recursivoFilaAvx512(const float *entrada, const double *s1, const double *s2, double *s3,
+                                            const double *coef, float *salida, size_t n)
+{
+    const __m512d c0 = _mm512_set1_pd(coef[0]), c1 = _mm512_set1_pd(coef[1]);
+    const __m512d c2 = _mm512_set1_pd(coef[2]), c3 = _mm512_set1_pd(coef[3]);
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8)
+    {
+        __m512d x = _mm512_cvtps_pd(_mm256_loadu_ps(entrada + j));
+        __m512d v = _mm512_add_pd(_mm512_mul_pd(c0, x), _mm512_mul_pd(c1, _mm512_loadu_pd(s1 + j)));
+        v = _mm512_add_pd(v, _mm512_mul_pd(c2, _mm512_loadu_pd(s2 + j)));
+        v = _mm512_add_pd(v, _mm512_mul_pd(c3, _mm512_loadu_pd(s3 + j)));
+        _mm512_storeu_pd(s3 + j, v);
+        _mm256_storeu_ps(salida + j, _mm512_cvtpd_ps(v));
+    }
+    recursivoFilaEscalar(entrada + j, s1 + j, s2 + j, s3 + j, coef, salida + j, n - j);
+}
+
+#endif // SIMD_X86
+
+// ---------- Selección ----------
+
+static NucleosSimd nucleos;
+static pthread_once_t nucleosElegidos = PTHREAD_ONCE_INIT;
+
+static void elegirNucleos(void)
+{
+    NucleosSimd n = {
+        "escalar",
+        brilloFilaEscalar,
+        convolucionHorizontalFilaEscalar,
+        convolucionVerticalFilaEscalar,
+        convolucionEnteraFilaEscalar,
+        sobelFilaEscalar,
+        resizeBilinealFilaEscalar,
+        transponer8x8Escalar,
+        lutFilaEscalar,
+        recursivoFilaEscalar,
+    };
+
+#if SIMD_X86
+    static const char *niveles[] = {"escalar", "sse2", "avx2", "avx512"};
+    __builtin_cpu_init();
+    int nivel = 0;
+    if (__builtin_cpu_supports("sse2"))
+        nivel = 1;
+    if (nivel == 1 && __builtin_cpu_supports("avx2"))
+        nivel = 2;
+    if (nivel == 2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        nivel = 3;
+
+    // IMG_SIMD solo puede bajar el nivel detectado
+    const char *forzado = getenv(SIMD_VARIABLE_NIVEL);
+    if (forzado && *forzado)
+    {
+        int pedido = -1;
+        for (int i = 0; i < 4; i++)
+            if (strcmp(forzado, niveles[i]) == 0)
+                pedido = i;
+        if (pedido < 0)
+            fprintf(stderr, "Valor inválido en %s: %s\n", SIMD_VARIABLE_NIVEL, forzado);
+        else if (pedido < nivel)
+            nivel = pedido;
+    }
+
+    if (nivel >= 1)
+    {
+        n.brilloFila = brilloFilaSse2;
+        n.convolucionHorizontalFila = convolucionHorizontalFilaSse2;
+        n.convolucionVerticalFila = convolucionVerticalFilaSse2;
+        n.convolucionEnteraFila = convolucionEnteraFilaSse2;
+        n.sobelFila = sobelFilaSse2;
+        n.transponer8x8 = transponer8x8Sse2;
+        n.recursivoFila = recursivoFilaSse2;
+    }
+    if (nivel >= 2)
+    {
+        n.brilloFila = brilloFilaAvx2;
+        n.convolucionHorizontalFila = convolucionHorizontalFilaAvx2;
+        n.convolucionVerticalFila = convolucionVerticalFilaAvx2;
+        n.convolucionEnteraFila = convolucionEnteraFilaAvx2;
+        n.sobelFila = sobelFilaAvx2;
+        n.resizeBilinealFila = resizeBilinealFilaAvx2;
+        n.lutFila = lutFilaAvx2;
+        n.recursivoFila = recursivoFilaAvx2;
+    }
+    if (nivel >= 3)
+    {
+        n.brilloFila = brilloFilaAvx512;
+        n.convolucionHorizontalFila = convolucionHorizontalFilaAvx512;
+        n.convolucionVerticalFila = convolucionVerticalFilaAvx512;
+        n.convolucionEnteraFila = convolucionEnteraFilaAvx512;
+        n.lutFila = lutFilaAvx512;
+        n.recursivoFila = recursivoFilaAvx512;
+    }
+    n.nombre = niveles[nivel];
+#endif
+
+    nucleos = n;
+}
+
+const NucleosSimd *nucleosSimd(void)
+{
+    pthread_once(&nucleosElegidos, elegirNucleos);
+    return &nucleos;
+}
@@ -0,0 +1,76 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Núcleos de los bucles internos (una fila por llamada) con varias
+// implementaciones: escalar (referencia), SSE2, AVX2 y AVX-512. La mejor
+// disponible se elige en tiempo de ejecución con cpuid; la variable de entorno
+// IMG_SIMD (escalar, sse2, avx2, avx512) limita el nivel. Todas las versiones
+// producen exactamente los mismos bytes que la escalar.
+
+// Variable de entorno que limita el nivel SIMD
+#define SIMD_VARIABLE_NIVEL "IMG_SIMD"
+
+typedef struct
+{
+    const char *nombre; // nivel elegido: "escalar", "sse2", "avx2" o "avx512"
+
+    // fila[i] = clamp(fila[i] + delta, 0, 255) para i en [0, n)
+    void (*brilloFila)(unsigned char *fila, size_t n, int delta);
+
+    // Pasada horizontal de una convolución 1D sobre una fila intercalada:
+    // salida[i] = suma_k fila[i + (k - tam/2) * canales] * kernel[k], i en
+    // [inicio, fin). Todos los taps deben caer dentro de la fila.
+    void (*convolucionHorizontalFila)(const unsigned char *fila, const float *kernel, int tam,
+                                      int canales, float *salida, size_t inicio, size_t fin);
+
+    // Pasada vertical: salida[i] = clamp(round(suma_k filas[k][i] * kernel[k]))
+    void (*convolucionVerticalFila)(const float *const *filas, const float *kernel, int tam,
+                                    unsigned char *salida, size_t n);
+
+    // Convolución 2D entera de tam x tam taps: para i en [0, n)
+    // salida[i] = clamp((r + suma_ky,kx filas[ky][i + kx * canales] * w(ky, kx))
+    // >> desplazamiento, 0, 255), con r = 2^(desplazamiento - 1) y la suma en
+    // int32 (el llamador garantiza que no desborda). pares[ky * ((tam + 1) / 2)
+    // + j] lleva w(ky, 2j) en los 16 bits bajos y w(ky, 2j + 1) (0 si no
+    // existe) en los altos.
+    void (*convolucionEnteraFila)(const unsigned char *const *filas, const int32_t *pares, int tam,
+                                  int canales, int desplazamiento, unsigned char *salida, size_t n);
+
+    // Magnitud de Sobel (1 canal) para x en [1, ancho - 1) a partir de las
+    // filas de arriba, centro y abajo.
+    void (*sobelFila)(const unsigned char *arriba, const unsigned char *centro,
+                      const unsigned char *abajo, unsigned char *salida, int ancho);
+
+    // Fila destino del redimensionado bilineal para x en [xInicio, xFin) con
+    // aritmética entera 8.8. Por columna: offset0/offset1 son los bytes de
+    // las columnas origen x0 y x1 y pesosX = (256 - wx) | wx << 16. Mezcla
+    // las filas origen f0 y f1 (de bytesFila bytes) con peso wy en [0, 256].
+    void (*resizeBilinealFila)(const unsigned char *f0, const unsigned char *f1, int wy,
+                               const int *offset0, const int *offset1, const int *pesosX,
+                               int canales, size_t bytesFila, unsigned char *salida,
+                               int xInicio, int xFin);
+
+    // Transpone un bloque de 8x8 bytes: destino[i][j] = origen[j][i]. Cada
+    // puntero apunta al primer byte de la fila del bloque.
+    void (*transponer8x8)(const unsigned char *const *origen, unsigned char *const *destino);
+
+    // Tabla de consulta sobre una fila intercalada: fila[i] = tabla[c * 256 +
+    // fila[i]] con c = i % canales. tabla debe poder leerse hasta el byte
+    // canales * 256 + 2 (las versiones vectoriales leen 4 bytes por entrada).
+    void (*lutFila)(unsigned char *fila, size_t n, const unsigned char *tabla, int canales);
+
+    // Un paso del filtro recursivo de orden 3 sobre n columnas independientes:
+    // w = coef[0] * entrada + coef[1] * s1 + coef[2] * s2 + coef[3] * s3 (en
+    // double, en ese orden), que se guarda en s3 y, como float, en salida.
+    // salida puede ser entrada.
+    void (*recursivoFila)(const float *entrada, const double *s1, const double *s2, double *s3,
+                          const double *coef, float *salida, size_t n);
+} NucleosSimd;
+
+// Devuelve los núcleos elegidos para esta CPU (se eligen en la primera llamada).
+const NucleosSimd *nucleosSimd(void);
+
+#endif // SIMD_H
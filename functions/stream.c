@@ -0,0 +1,682 @@
+// Procesamiento por franjas: cada etapa recibe filas de la anterior, calcula
+// las que ya puede y las pasa a la siguiente; la última las escribe al PNG.
+
+#include "stream.h"
+#include "border.h"
+#include "brightness.h"
+#include "flip.h"
+#include "png_writer.h"
+#include "resize.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FILAS_FRANJA_MINIMO 32
+#define FILAS_FRANJA_MAXIMO 1024
+
+// ---------- Fuente ----------
+
+int archivoEsPNM(const char *ruta)
+{
+    FILE *f = fopen(ruta, "rb");
+    if (!f)
+        return 0;
+    unsigned char magia[2] = {0, 0};
+    size_t leidos = fread(magia, 1, 2, f);
+    fclose(f);
+    return leidos == 2 && magia[0] == 'P' && (magia[1] == '5' || magia[1] == '6');
+}
+
+// Siguiente número de la cabecera, saltando espacios y comentarios (#)
+static int leerNumeroPNM(FILE *f, int *valor)
+{
+    int c = fgetc(f);
+    while (c != EOF)
+    {
+        if (c == '#')
+        {
+            while (c != EOF && c != '\n')
+                c = fgetc(f);
+        }
+        else if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+            c = fgetc(f);
+        else
+            break;
+    }
+    if (c < '0' || c > '9')
+        return 0;
+    long n = 0;
+    while (c >= '0' && c <= '9')
+    {
+        n = n * 10 + (c - '0');
+        if (n > 0x7FFFFFFF)
+            return 0;
+        c = fgetc(f);
+    }
+    // Un único espacio separa la cabecera de los datos
+    if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+        return 0;
+    *valor = (int)n;
+    return 1;
+}
+
+// Lee la cabecera sin mensajes; deja f al principio de los píxeles
+static int leerCabeceraPNM(FILE *f, int *ancho, int *alto, int *canales, int *maximo)
+{
+    char magia[2];
+    if (fread(magia, 1, 2, f) != 2 || magia[0] != 'P' || (magia[1] != '5' && magia[1] != '6') ||
+        !leerNumeroPNM(f, ancho) || !leerNumeroPNM(f, alto) || !leerNumeroPNM(f, maximo) ||
+        *ancho <= 0 || *alto <= 0)
+        return 0;
+    *canales = magia[1] == '5' ? 1 : 3;
+    return 1;
+}
+
+int cabeceraPNM(const char *ruta, int *ancho, int *alto, int *canales)
+{
+    FILE *f = fopen(ruta, "rb");
+    if (!f)
+        return 0;
+    int maximo;
+    int ok = leerCabeceraPNM(f, ancho, alto, canales, &maximo) && maximo == 255;
+    fclose(f);
+    return ok;
+}
+
+int fuenteAbrirPNM(FuenteFranjas *fuente, const char *ruta)
+{
+    memset(fuente, 0, sizeof(*fuente));
+    FILE *f = fopen(ruta, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "No se pudo abrir %s\n", ruta);
+        return 0;
+    }
+    int ancho, alto, canales, maximo;
+    if (!leerCabeceraPNM(f, &ancho, &alto, &canales, &maximo))
+    {
+        fprintf(stderr, "Cabecera PNM inválida: %s\n", ruta);
+        fclose(f);
+        return 0;
+    }
+    if (!imagenTamanoValido(ancho, alto, canales, NULL))
+    {
+        fprintf(stderr, "Tamaño de imagen inválido (%dx%d): %s\n", ancho, alto, ruta);
+        fclose(f);
+        return 0;
+    }
+    if (maximo != 255)
+    {
+        fprintf(stderr, "Solo se admiten PNM de 8 bits (maxval 255): %s\n", ruta);
+        fclose(f);
+        return 0;
+    }
+    fuente->ancho = ancho;
+    fuente->alto = alto;
+    fuente->canales = canales;
+    fuente->archivo = f;
+    return 1;
+}
+
+void fuenteDesdeImagen(FuenteFranjas *fuente, ImagenInfo *imagen)
+{
+    memset(fuente, 0, sizeof(*fuente));
+    fuente->ancho = imagen->ancho;
+    fuente->alto = imagen->alto;
+    fuente->canales = imagen->canales;
+    fuente->imagen = imagen;
+}
+
+void fuenteCerrar(FuenteFranjas *fuente)
+{
+    if (fuente->archivo)
+        fclose(fuente->archivo);
+    fuente->archivo = NULL;
+    fuente->imagen = NULL;
+}
+
+// ---------- Etapas ----------
+
+typedef struct
+{
+    EtapaFranjas etapa;
+    int anchoEntrada, altoEntrada, canalesEntrada;
+    int anchoSalida, altoSalida, canalesSalida;
+    int halo;                // filas vecinas que necesita cada fila de salida
+    unsigned char *buffer;   // filas de entrada [primeraFila, primeraFila + numFilas)
+    unsigned char **filas;   // punteros a esas filas
+    int capacidad;           // filas que caben en buffer
+    int primeraFila;
+    int numFilas;
+    int siguienteSalida;     // primera fila de salida sin calcular
+    ResizeFranjas *resize;
+} EstadoEtapa;
+
+typedef struct
+{
+    EstadoEtapa *etapas;
+    int numEtapas;
+    int filasPorFranja;
+    int numHilos;
+    EscritorPNG *png;        // salida a PNG, o si es NULL...
+    ImagenInfo *destino;     // ...a esta imagen, a partir de filaDestino
+    int filaDestino;
+} CadenaFranjas;
+
+static size_t bytesFilaEntrada(const EstadoEtapa *e)
+{
+    return (size_t)e->anchoEntrada * e->canalesEntrada;
+}
+
+// Vista sobre filas ajenas: liberarImagen solo libera el arreglo de punteros
+static int crearVista(ImagenInfo *vista, unsigned char *const *filas, int n, int ancho, int canales)
+{
+    memset(vista, 0, sizeof(*vista));
+    vista->pixeles = (unsigned char **)malloc((size_t)n * sizeof(unsigned char *));
+    if (!vista->pixeles)
+    {
+        fprintf(stderr, "Error de memoria en el procesamiento por franjas\n");
+        return 0;
+    }
+    memcpy(vista->pixeles, filas, (size_t)n * sizeof(unsigned char *));
+    vista->ancho = ancho;
+    vista->alto = n;
+    vista->canales = canales;
+    vista->paso = (size_t)ancho * canales;
+    return 1;
+}
+
+// Copia de filas a otras (con la tabla de entrada de la etapa, si tiene)
+typedef struct
+{
+    unsigned char *const *origen;
+    unsigned char *const *destino;
+    size_t bytesFila;
+    const LutPuntual *lut; // NULL = copia tal cual
+    int canales;
+} CopiaFilas;
+
+static void copiarFilasRango(void *ctx, int inicio, int fin)
+{
+    const CopiaFilas *copia = (const CopiaFilas *)ctx;
+    const NucleosSimd *simd = nucleosSimd();
+    for (int k = inicio; k < fin; k++)
+    {
+        if (copia->destino[k] != copia->origen[k])
+            memcpy(copia->destino[k], copia->origen[k], copia->bytesFila);
+        if (copia->lut)
+            simd->lutFila(copia->destino[k], copia->bytesFila, &copia->lut->tabla[0][0], copia->canales);
+    }
+}
+
+// Con etapa, aplica su tabla de entrada si tiene operaciones puntuales fundidas
+static void copiarFilas(unsigned char *const *origen, unsigned char *const *destino, int n,
+                        const EstadoEtapa *etapa, size_t bytesFila, int numHilos)
+{
+    CopiaFilas copia = {origen, destino, bytesFila, NULL, 0};
+    if (etapa && etapa->etapa.fundirLut)
+    {
+        copia.lut = &etapa->etapa.lut;
+        copia.canales = etapa->canalesEntrada;
+    }
+    poolParaleloForTeselas(n, numHilos, poolFilasPorTesela(bytesFila), copiarFilasRango, &copia);
+}
+
+// Copia n filas al final del buffer de la etapa
+static int guardarFilas(EstadoEtapa *e, unsigned char *const *filas, int n, int numHilos)
+{
+    const size_t bytesFila = bytesFilaEntrada(e);
+    if (e->numFilas + n > e->capacidad)
+    {
+        int capacidad = e->capacidad * 2 > e->numFilas + n ? e->capacidad * 2 : e->numFilas + n;
+        unsigned char *buffer = (unsigned char *)realloc(e->buffer, (size_t)capacidad * bytesFila);
+        unsigned char **punteros = (unsigned char **)realloc(e->filas, (size_t)capacidad * sizeof(unsigned char *));
+        if (buffer)
+            e->buffer = buffer;
+        if (punteros)
+            e->filas = punteros;
+        if (!buffer || !punteros)
+        {
+            fprintf(stderr, "Error de memoria en el procesamiento por franjas\n");
+            return 0;
+        }
+        e->capacidad = capacidad;
+        for (int k = 0; k < capacidad; k++)
+            e->filas[k] = e->buffer + (size_t)k * bytesFila;
+    }
+    copiarFilas(filas, e->filas + e->numFilas, n, e, bytesFila, numHilos);
+    e->numFilas += n;
+    return 1;
+}
+
+// Olvida las filas de entrada anteriores a fila
+static void descartarFilas(EstadoEtapa *e, int fila)
+{
+    int k = fila - e->primeraFila;
+    if (k <= 0)
+        return;
+    if (k > e->numFilas)
+        k = e->numFilas;
+    // Con k == numFilas (etapa sin halo) e->filas[k] puede estar fuera del array
+    memmove(e->buffer, e->buffer + (size_t)k * bytesFilaEntrada(e), (size_t)(e->numFilas - k) * bytesFilaEntrada(e));
+    e->primeraFila += k;
+    e->numFilas -= k;
+}
+
+static int empujarFilas(CadenaFranjas *c, int indice, unsigned char *const *filas, int n);
+
+// Operaciones con vecindad sobre una ventana de filas (reemplazan la imagen)
+static int aplicarVecindad(ImagenInfo *ventana, const EstadoEtapa *e, int numHilos)
+{
+    switch (e->etapa.tipo)
+    {
+    case ETAPA_DESENFOQUE:
+        return aplicarConvolucionSeparable(ventana, e->etapa.tamKernel, e->etapa.sigma, numHilos);
+    case ETAPA_KERNEL:
+        return aplicarKernelConcurrente(ventana, e->etapa.kernel->pesos, e->etapa.kernel->tam, numHilos);
+    case ETAPA_SOBEL:
+        return detectarBordesSobel(ventana, numHilos);
+    default:
+        return 0;
+    }
+}
+
+// Calcula las filas de salida que ya tienen todo su halo. La ventana lleva
+// halo filas de más a cada lado (salvo en los bordes reales de la imagen),
+// así que las filas que se conservan no notan el recorte.
+static int avanzarVecindad(CadenaFranjas *c, int indice)
+{
+    EstadoEtapa *e = &c->etapas[indice];
+    const int recibidas = e->primeraFila + e->numFilas;
+    const int completa = recibidas == e->altoEntrada;
+    const int listas = completa ? e->altoEntrada : recibidas - e->halo;
+
+    while (e->siguienteSalida < listas &&
+           (completa || listas - e->siguienteSalida >= c->filasPorFranja))
+    {
+        const int s = e->siguienteSalida;
+        const int t = listas - s > c->filasPorFranja ? s + c->filasPorFranja : listas;
+        const int a = s - e->halo > 0 ? s - e->halo : 0;
+        const int b = t + e->halo < e->altoEntrada ? t + e->halo : e->altoEntrada;
+
+        ImagenInfo ventana;
+        if (!crearVista(&ventana, e->filas + (a - e->primeraFila), b - a, e->anchoEntrada, e->canalesEntrada))
+            return 0;
+        int ok = aplicarVecindad(&ventana, e, c->numHilos);
+        if (ok)
+            ok = empujarFilas(c, indice + 1, ventana.pixeles + (s - a), t - s);
+        liberarImagen(&ventana);
+        if (!ok)
+            return 0;
+        e->siguienteSalida = t;
+        descartarFilas(e, t - e->halo);
+    }
+    return 1;
+}
+
+// Calcula franjas de filas destino en cuanto están sus filas origen
+static int avanzarResize(CadenaFranjas *c, int indice)
+{
+    EstadoEtapa *e = &c->etapas[indice];
+    const int recibidas = e->primeraFila + e->numFilas;
+
+    while (e->siguienteSalida < e->altoSalida)
+    {
+        const int y0 = e->siguienteSalida;
+        int y1 = y0;
+        int desde, hasta;
+        while (y1 < e->altoSalida && y1 - y0 < c->filasPorFranja)
+        {
+            resizeFranjasFilasOrigen(e->resize, y1, &desde, &hasta);
+            if (hasta > recibidas)
+                break;
+            y1++;
+        }
+        // Franjas completas, salvo la última
+        if (y1 - y0 < c->filasPorFranja && y1 < e->altoSalida)
+            break;
+
+        ImagenInfo salida;
+        if (!crearImagen(&salida, e->anchoSalida, y1 - y0, e->canalesSalida))
+            return 0;
+        int ok = resizeFranjasProcesar(e->resize, e->filas, e->primeraFila, recibidas,
+                                       salida.pixeles, y0, y1, c->numHilos);
+        if (ok)
+            ok = empujarFilas(c, indice + 1, salida.pixeles, y1 - y0);
+        liberarImagen(&salida);
+        if (!ok)
+            return 0;
+        e->siguienteSalida = y1;
+        if (y1 < e->altoSalida)
+        {
+            resizeFranjasFilasOrigen(e->resize, y1, &desde, &hasta);
+            descartarFilas(e, desde);
+        }
+    }
+    return 1;
+}
+
+typedef struct
+{
+    unsigned char *const *origen;
+    unsigned char *const *destino;
+    int ancho;
+} GrisesFilas;
+
+// Promedio de los tres canales, igual que el gris de Sobel
+static void grisesRango(void *ctx, int inicio, int fin)
+{
+    const GrisesFilas *g = (const GrisesFilas *)ctx;
+    for (int k = inicio; k < fin; k++)
+    {
+        const unsigned char *p = g->origen[k];
+        unsigned char *d = g->destino[k];
+        for (int x = 0; x < g->ancho; x++, p += 3)
+            d[x] = (unsigned char)((p[0] + p[1] + p[2]) / 3);
+    }
+}
+
+static int convertirAGrises(CadenaFranjas *c, int indice, unsigned char *const *filas, int n)
+{
+    EstadoEtapa *e = &c->etapas[indice];
+    if (e->etapa.fundirLut)
+        copiarFilas(filas, filas, n, e, bytesFilaEntrada(e), c->numHilos);
+    if (e->canalesEntrada == 1)
+        return empujarFilas(c, indice + 1, filas, n);
+
+    ImagenInfo grises;
+    if (!crearImagen(&grises, e->anchoEntrada, n, 1))
+        return 0;
+    GrisesFilas g = {filas, grises.pixeles, e->anchoEntrada};
+    poolParaleloForTeselas(n, c->numHilos, poolFilasPorTesela(bytesFilaEntrada(e)), grisesRango, &g);
+    int ok = empujarFilas(c, indice + 1, grises.pixeles, n);
+    liberarImagen(&grises);
+    return ok;
+}
+
+// Entrega n filas consecutivas a la etapa indice (o al PNG tras la última)
+static int empujarFilas(CadenaFranjas *c, int indice, unsigned char *const *filas, int n)
+{
+    if (n <= 0)
+        return 1;
+    if (indice == c->numEtapas)
+    {
+        if (c->png)
+            return pngEscribirFilas(c->png, filas, n);
+        copiarFilas(filas, c->destino->pixeles + c->filaDestino, n, NULL, c->destino->paso, c->numHilos);
+        c->filaDestino += n;
+        return 1;
+    }
+
+    EstadoEtapa *e = &c->etapas[indice];
+    switch (e->etapa.tipo)
+    {
+    case ETAPA_LUT:
+    case ETAPA_BRILLO:
+    case ETAPA_VOLTEO_H:
+    {
+        // Sin vecindad: en el sitio sobre las mismas filas
+        if (e->etapa.fundirLut)
+            copiarFilas(filas, filas, n, e, bytesFilaEntrada(e), c->numHilos);
+        ImagenInfo vista;
+        if (!crearVista(&vista, filas, n, e->anchoEntrada, e->canalesEntrada))
+            return 0;
+        int ok;
+        if (e->etapa.tipo == ETAPA_LUT)
+            ok = aplicarLutConcurrente(&vista, &e->etapa.lut, c->numHilos);
+        else if (e->etapa.tipo == ETAPA_BRILLO)
+            ok = ajustarBrilloConcurrente(&vista, e->etapa.delta, c->numHilos);
+        else
+            ok = voltearHorizontal(&vista, c->numHilos);
+        liberarImagen(&vista);
+        return ok && empujarFilas(c, indice + 1, filas, n);
+    }
+    case ETAPA_GRISES:
+        return convertirAGrises(c, indice, filas, n);
+    case ETAPA_RESIZE:
+        return guardarFilas(e, filas, n, c->numHilos) && avanzarResize(c, indice);
+    default:
+        return guardarFilas(e, filas, n, c->numHilos) && avanzarVecindad(c, indice);
+    }
+}
+
+// Tamaños de salida y halo de la etapa a partir de su entrada
+static int prepararEtapa(EstadoEtapa *e, const EtapaFranjas *etapa, int ancho, int alto, int canales)
+{
+    memset(e, 0, sizeof(*e));
+    e->etapa = *etapa;
+    e->anchoEntrada = e->anchoSalida = ancho;
+    e->altoEntrada = e->altoSalida = alto;
+    e->canalesEntrada = e->canalesSalida = canales;
+
+    switch (etapa->tipo)
+    {
+    case ETAPA_DESENFOQUE:
+        if (!(etapa->sigma > 0.0f))
+        {
+            fprintf(stderr, "Sigma debe ser mayor que 0\n");
+            return 0;
+        }
+        // Automático: el kernel cubre +-3 sigma
+        if (e->etapa.tamKernel <= 0)
+            e->etapa.tamKernel = 2 * (int)ceilf(3.0f * etapa->sigma) + 1;
+        if (e->etapa.tamKernel % 2 == 0)
+        {
+            fprintf(stderr, "El tamaño del kernel debe ser impar (3, 5, 7, etc.)\n");
+            return 0;
+        }
+        e->halo = e->etapa.tamKernel / 2;
+        return 1;
+    case ETAPA_KERNEL:
+        e->halo = etapa->kernel->tam / 2;
+        return 1;
+    case ETAPA_SOBEL:
+        e->halo = 1;
+        e->canalesSalida = 1;
+        return 1;
+    case ETAPA_GRISES:
+        if (canales != 1 && canales != 3)
+        {
+            fprintf(stderr, "La conversión a grises necesita 1 o 3 canales\n");
+            return 0;
+        }
+        e->canalesSalida = 1;
+        return 1;
+    case ETAPA_RESIZE:
+        e->anchoSalida = etapa->ancho;
+        e->altoSalida = etapa->alto;
+        e->resize = resizeFranjasCrear(ancho, alto, etapa->ancho, etapa->alto, canales, etapa->filtro);
+        return e->resize != NULL;
+    default:
+        return 1;
+    }
+}
+
+static void escribirArchivo(void *ctx, const void *datos, size_t largo)
+{
+    fwrite(datos, 1, largo, (FILE *)ctx);
+}
+
+// Lee y entrega a la cadena todas las filas de la fuente
+static int leerFuente(CadenaFranjas *c, FuenteFranjas *fuente)
+{
+    if (fuente->imagen)
+    {
+        // Ya en memoria: se entregan sus propias filas
+        for (int y = fuente->siguiente; y < fuente->alto; y += c->filasPorFranja)
+        {
+            int n = fuente->alto - y < c->filasPorFranja ? fuente->alto - y : c->filasPorFranja;
+            if (!empujarFilas(c, 0, fuente->imagen->pixeles + y, n))
+                return 0;
+        }
+        fuente->siguiente = fuente->alto;
+        return 1;
+    }
+
+    ImagenInfo franja;
+    if (!crearImagen(&franja, fuente->ancho, c->filasPorFranja, fuente->canales))
+        return 0;
+    const size_t bytesFila = (size_t)fuente->ancho * fuente->canales;
+    int ok = 1;
+    while (ok && fuente->siguiente < fuente->alto)
+    {
+        int n = fuente->alto - fuente->siguiente;
+        if (n > c->filasPorFranja)
+            n = c->filasPorFranja;
+        if (fread(franja.datos, bytesFila, (size_t)n, fuente->archivo) != (size_t)n)
+        {
+            fprintf(stderr, "El archivo PNM termina antes de la fila %d\n", fuente->siguiente + n);
+            ok = 0;
+            break;
+        }
+        fuente->siguiente += n;
+        ok = empujarFilas(c, 0, franja.pixeles, n);
+    }
+    liberarImagen(&franja);
+    return ok;
+}
+
+// Prepara las etapas a partir de los tamaños de la fuente y elige la altura
+// de franja. Deja en *ancho, *alto y *canales los de la salida.
+static int prepararCadena(CadenaFranjas *c, const EtapaFranjas *etapas, int numEtapas, int ancho, int alto,
+                          int canales, int filasPorFranja, size_t bytesPorFranja, int numHilos, int *anchoSalida,
+                          int *altoSalida, int *canalesSalida)
+{
+    memset(c, 0, sizeof(*c));
+    c->etapas = (EstadoEtapa *)calloc(numEtapas > 0 ? (size_t)numEtapas : 1, sizeof(EstadoEtapa));
+    c->numHilos = poolResolverHilos(numHilos);
+    if (!c->etapas)
+    {
+        fprintf(stderr, "Error de memoria en el procesamiento por franjas\n");
+        return 0;
+    }
+
+    // Tamaños a lo largo de la cadena; la franja sale de la fila más ancha
+    size_t bytesFilaMaximo = (size_t)ancho * canales;
+    int haloMaximo = 0;
+    for (; c->numEtapas < numEtapas; c->numEtapas++)
+    {
+        EstadoEtapa *e = &c->etapas[c->numEtapas];
+        if (!prepararEtapa(e, &etapas[c->numEtapas], ancho, alto, canales))
+            return 0;
+        ancho = e->anchoSalida;
+        alto = e->altoSalida;
+        canales = e->canalesSalida;
+        if ((size_t)ancho * canales > bytesFilaMaximo)
+            bytesFilaMaximo = (size_t)ancho * canales;
+        if (e->halo > haloMaximo)
+            haloMaximo = e->halo;
+    }
+
+    if (filasPorFranja <= 0)
+    {
+        size_t filas = bytesPorFranja / bytesFilaMaximo;
+        filasPorFranja = filas < FILAS_FRANJA_MINIMO ? FILAS_FRANJA_MINIMO
+                         : (filas > FILAS_FRANJA_MAXIMO ? FILAS_FRANJA_MAXIMO : (int)filas);
+        // Que el halo no domine el trabajo de cada ventana
+        if (filasPorFranja < 4 * haloMaximo)
+            filasPorFranja = 4 * haloMaximo;
+    }
+    c->filasPorFranja = filasPorFranja;
+    *anchoSalida = ancho;
+    *altoSalida = alto;
+    *canalesSalida = canales;
+    return 1;
+}
+
+static void liberarCadena(CadenaFranjas *c)
+{
+    for (int i = 0; i < c->numEtapas; i++)
+    {
+        free(c->etapas[i].buffer);
+        free(c->etapas[i].filas);
+        resizeFranjasLiberar(c->etapas[i].resize);
+    }
+    free(c->etapas);
+    c->etapas = NULL;
+}
+
+// Las operaciones de cada ventana no imprimen nada: solo el resumen final
+static int leerFuenteEnSilencio(CadenaFranjas *c, FuenteFranjas *fuente)
+{
+    const int silencioso = imagenModoSilencioso;
+    imagenModoSilencioso = 1;
+    int ok = leerFuente(c, fuente);
+    imagenModoSilencioso = silencioso;
+    return ok;
+}
+
+int procesarPorFranjas(FuenteFranjas *fuente, const EtapaFranjas *etapas, int numEtapas,
+                       const char *rutaSalida, int filasPorFranja, int numHilos)
+{
+    CadenaFranjas cadena;
+    int ancho, alto, canales;
+    int ok = prepararCadena(&cadena, etapas, numEtapas, fuente->ancho, fuente->alto, fuente->canales,
+                            filasPorFranja, BYTES_POR_FRANJA, numHilos, &ancho, &alto, &canales);
+
+    FILE *f = NULL;
+    if (ok)
+    {
+        f = fopen(rutaSalida, "wb");
+        if (!f)
+        {
+            fprintf(stderr, "No se pudo crear %s\n", rutaSalida);
+            ok = 0;
+        }
+    }
+    if (ok)
+    {
+        cadena.png = pngAbrir(escribirArchivo, f, ancho, alto, canales);
+        ok = cadena.png != NULL;
+    }
+    if (ok)
+        ok = leerFuenteEnSilencio(&cadena, fuente);
+    if (cadena.png && !pngCerrar(cadena.png))
+        ok = 0;
+    if (f && fclose(f) != 0)
+        ok = 0;
+    liberarCadena(&cadena);
+
+    if (ok)
+        IMG_INFO("Imagen procesada por franjas de %d filas (%d etapas, salida %dx%d, %s).\n",
+                 cadena.filasPorFranja, numEtapas, ancho, alto, canales == 1 ? "grises" : "RGB");
+    return ok;
+}
+
+int procesarEnMemoria(ImagenInfo *info, const EtapaFranjas *etapas, int numEtapas, int filasPorFranja,
+                      int numHilos)
+{
+    if (!info->pixeles)
+    {
+        fprintf(stderr, "No hay imagen cargada.\n");
+        return 0;
+    }
+
+    // Franjas de unas pocas teselas por hilo: los intermedios caben en caché
+    CadenaFranjas cadena;
+    int ancho, alto, canales;
+    const size_t bytesPorFranja = (size_t)BYTES_FRANJA_CACHE * poolResolverHilos(numHilos);
+    int ok = prepararCadena(&cadena, etapas, numEtapas, info->ancho, info->alto, info->canales, filasPorFranja,
+                            bytesPorFranja, numHilos, &ancho, &alto, &canales);
+
+    ImagenInfo resultado = {0};
+    if (ok)
+        ok = crearImagen(&resultado, ancho, alto, canales);
+    if (ok)
+    {
+        FuenteFranjas fuente;
+        fuenteDesdeImagen(&fuente, info);
+        cadena.destino = &resultado;
+        ok = leerFuenteEnSilencio(&cadena, &fuente) && cadena.filaDestino == alto;
+    }
+    liberarCadena(&cadena);
+    if (!ok)
+    {
+        liberarImagen(&resultado);
+        return 0;
+    }
+    reemplazarImagen(info, &resultado);
+    return 1;
+}
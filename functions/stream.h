@@ -0,0 +1,88 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdio.h>
+#include "imagen_info.h"
+#include "convolution.h"
+#include "point.h"
+
+// Procesamiento por franjas de filas para imágenes que no caben en memoria.
+// La entrada se lee de arriba hacia abajo en franjas, cada etapa de la
+// cadena guarda solo las filas vecinas que necesita (tamKernel / 2 en el
+// desenfoque, 1 en Sobel, la ventana origen en el redimensionado) y el PNG
+// de salida se escribe a medida que salen las franjas. El resultado es el
+// mismo que aplicar las operaciones a la imagen completa.
+
+// Bytes aproximados de cada franja cuando no se pide un número de filas
+#define BYTES_POR_FRANJA (4 << 20)
+
+// En memoria (procesarEnMemoria), bytes de franja por hilo: la fila más
+// ancha de la cadena por las filas de la franja cabe en la caché L2
+#define BYTES_FRANJA_CACHE (256 * 1024)
+
+typedef enum
+{
+    ETAPA_LUT,        // tabla de operaciones puntuales ya compuesta
+    ETAPA_BRILLO,
+    ETAPA_DESENFOQUE, // kernel separable (vecindad acotada), nunca el recursivo
+    ETAPA_KERNEL,
+    ETAPA_SOBEL,
+    ETAPA_RESIZE,
+    ETAPA_VOLTEO_H,
+    ETAPA_GRISES      // promedio de los tres canales (el mismo gris que Sobel)
+} TipoEtapa;
+
+typedef struct
+{
+    TipoEtapa tipo;
+    LutPuntual lut;               // LUT
+    int delta;                    // BRILLO
+    int tamKernel;                // DESENFOQUE (<= 0 automático)
+    float sigma;                  // DESENFOQUE
+    const KernelUsuario *kernel;  // KERNEL
+    int ancho, alto;              // RESIZE
+    int filtro;                   // RESIZE: -1 = bilineal, si no un FiltroResize
+    int fundirLut;                // otras etapas: aplicar lut a las filas al entrar
+} EtapaFranjas;
+
+// Origen de las filas: un PNM binario (P5/P6, maxval 255) leído del disco
+// a medida que se necesita, o una imagen ya cargada
+typedef struct
+{
+    int ancho;
+    int alto;
+    int canales;
+    int siguiente;       // próxima fila a leer
+    FILE *archivo;       // PNM abierto, NULL si viene de imagen
+    ImagenInfo *imagen;  // sus filas se modifican en el sitio
+} FuenteFranjas;
+
+// Devuelve 1 si el archivo empieza como un PNM binario (P5 o P6)
+int archivoEsPNM(const char *ruta);
+
+// Lee la cabecera de un PNM binario de 8 bits sin escribir mensajes.
+// Devuelve 0 si no es un PNM que fuenteAbrirPNM pueda leer.
+int cabeceraPNM(const char *ruta, int *ancho, int *alto, int *canales);
+
+// Abre un PNM y lee su cabecera. Devuelve 1 si todo fue bien.
+int fuenteAbrirPNM(FuenteFranjas *fuente, const char *ruta);
+
+// Fuente sobre una imagen ya cargada (formatos que no se decodifican por franjas)
+void fuenteDesdeImagen(FuenteFranjas *fuente, ImagenInfo *imagen);
+
+void fuenteCerrar(FuenteFranjas *fuente);
+
+// Aplica las etapas en orden a las filas de la fuente y guarda el PNG en
+// rutaSalida. filasPorFranja <= 0 lo calcula a partir de BYTES_POR_FRANJA;
+// numHilos <= 0 usa el número de hilos por defecto del pool.
+// Devuelve 1 si todo fue bien.
+int procesarPorFranjas(FuenteFranjas *fuente, const EtapaFranjas *etapas, int numEtapas,
+                       const char *rutaSalida, int filasPorFranja, int numHilos);
+
+// Igual que procesarPorFranjas sobre una imagen en memoria, que se
+// reemplaza por el resultado. Las franjas son de unas BYTES_FRANJA_CACHE
+// por hilo para que los intermedios entre etapas no salgan de la caché.
+int procesarEnMemoria(ImagenInfo *info, const EtapaFranjas *etapas, int numEtapas, int filasPorFranja,
+                      int numHilos);
+
+#endif // STREAM_H
@@ -0,0 +1,365 @@
+#define _GNU_SOURCE // sched_getaffinity y CPU_COUNT
+#include "thread_pool.h"
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Tamaño objetivo de una tesela (filas contiguas): cabe holgada en L2 junto
+// con su salida, y es lo bastante grande para que tomarla cueste poco
+#define BYTES_POR_TESELA (64 * 1024)
+
+// Teselas por hilo cuando la operación no da un tamaño (reparto por defecto)
+#define TESELAS_POR_HILO 8
+
+// Cola de teselas de un participante. Siempre es un rango contiguo
+// [inicio, fin): el dueño toma por delante y los ladrones roban por detrás.
+typedef struct
+{
+    pthread_mutex_t mutex;
+    int inicio;
+    int fin;
+} ColaTeselas;
+
+// Estado global del pool. Un único trabajo activo a la vez: el mutex envio
+// serializa a quienes llaman a poolParaleloFor.
+static struct
+{
+    pthread_t *hilos;
+    int numTrabajadores;
+    int iniciado;
+    int salir;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t hayTrabajo;
+    pthread_cond_t terminado;
+    pthread_mutex_t envio;
+
+    ColaTeselas *colas; // una por participante posible (trabajadores + quien llama)
+
+    // Trabajo actual
+    TareaRango tarea;
+    void *ctx;
+    int total;
+    int filasPorTesela;
+    int numParticipantes; // colas en uso en este trabajo
+    int siguienteId;      // próxima cola libre para un trabajador que se une
+    int activos;          // participantes que aún no terminaron
+    int abierto;          // se pueden unir trabajadores
+    unsigned long generacion;
+} pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .hayTrabajo = PTHREAD_COND_INITIALIZER,
+    .terminado = PTHREAD_COND_INITIALIZER,
+    .envio = PTHREAD_MUTEX_INITIALIZER,
+};
+
+// Valor fijado con poolFijarHilosPorDefecto (0 = automático)
+static int hilosForzados = 0;
+static int avisoEntorno = 0; // IMG_HILOS inválido ya avisado
+
+// Marca los hilos del pool para ejecutar en serie llamadas anidadas
+static __thread int esHiloDelPool = 0;
+
+static void ejecutarTesela(int t)
+{
+    int inicio = t * pool.filasPorTesela;
+    int fin = inicio + pool.filasPorTesela;
+    if (fin > pool.total)
+        fin = pool.total;
+    pool.tarea(pool.ctx, inicio, fin);
+}
+
+// Roba la mitad trasera de la cola de otro participante y la deja en la
+// propia. Devuelve 0 si todas las colas están vacías.
+static int robarTeselas(int id)
+{
+    for (int k = 1; k < pool.numParticipantes; k++)
+    {
+        ColaTeselas *victima = &pool.colas[(id + k) % pool.numParticipantes];
+        pthread_mutex_lock(&victima->mutex);
+        int quedan = victima->fin - victima->inicio;
+        if (quedan <= 0)
+        {
+            pthread_mutex_unlock(&victima->mutex);
+            continue;
+        }
+        int robadas = (quedan + 1) / 2;
+        victima->fin -= robadas;
+        int desde = victima->fin;
+        pthread_mutex_unlock(&victima->mutex);
+
+        ColaTeselas *propia = &pool.colas[id];
+        pthread_mutex_lock(&propia->mutex);
+        propia->inicio = desde;
+        propia->fin = desde + robadas;
+        pthread_mutex_unlock(&propia->mutex);
+        return 1;
+    }
+    return 0;
+}
+
+// Procesa la cola del participante id y, cuando se vacía, roba de las demás
+// hasta que no quede trabajo. Al salir se da de baja del trabajo.
+static void participar(int id)
+{
+    ColaTeselas *propia = &pool.colas[id];
+    do
+    {
+        while (1)
+        {
+            pthread_mutex_lock(&propia->mutex);
+            if (propia->inicio >= propia->fin)
+            {
+                pthread_mutex_unlock(&propia->mutex);
+                break;
+            }
+            int t = propia->inicio++;
+            pthread_mutex_unlock(&propia->mutex);
+            ejecutarTesela(t);
+        }
+    } while (robarTeselas(id));
+
+    // Quien sale último vio todas las colas vacías y nadie más tiene
+    // teselas en curso: el trabajo terminó
+    pthread_mutex_lock(&pool.mutex);
+    if (--pool.activos == 0)
+    {
+        pool.abierto = 0;
+        pthread_cond_broadcast(&pool.terminado);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+}
+
+static void *trabajadorPool(void *arg)
+{
+    (void)arg;
+    esHiloDelPool = 1;
+    unsigned long vista = 0;
+
+    pthread_mutex_lock(&pool.mutex);
+    while (1)
+    {
+        while (!pool.salir && pool.generacion == vista)
+            pthread_cond_wait(&pool.hayTrabajo, &pool.mutex);
+        if (pool.salir)
+            break;
+        vista = pool.generacion;
+
+        // Unirse solo si el trabajo sigue abierto y le queda una cola libre;
+        // si no, sus teselas ya las robaron (o las robarán) los demás
+        if (pool.abierto && pool.siguienteId < pool.numParticipantes)
+        {
+            int id = pool.siguienteId++;
+            pool.activos++;
+            pthread_mutex_unlock(&pool.mutex);
+            participar(id);
+            pthread_mutex_lock(&pool.mutex);
+        }
+    }
+    pthread_mutex_unlock(&pool.mutex);
+    return NULL;
+}
+
+// CPUs en las que puede ejecutarse el proceso
+static int cpusDisponibles(void)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0)
+    {
+        int n = CPU_COUNT(&cpus);
+        if (n > 0)
+            return n;
+    }
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+int poolLeerHilos(const char *texto, int *n)
+{
+    char *fin;
+    errno = 0;
+    long v = strtol(texto, &fin, 10);
+    if (fin == texto || *fin != '\0' || errno == ERANGE || v <= 0 || v > INT_MAX)
+        return 0;
+    *n = (int)v;
+    return 1;
+}
+
+int poolHilosPorDefecto(void)
+{
+    if (hilosForzados > 0)
+        return hilosForzados;
+
+    const char *entorno = getenv(POOL_VARIABLE_HILOS);
+    if (entorno && *entorno)
+    {
+        int n;
+        if (poolLeerHilos(entorno, &n))
+            return n;
+        if (!avisoEntorno)
+            fprintf(stderr, "Valor inválido en %s: %s (se usa el número de CPUs)\n",
+                    POOL_VARIABLE_HILOS, entorno);
+        avisoEntorno = 1;
+    }
+    return cpusDisponibles();
+}
+
+void poolFijarHilosPorDefecto(int n)
+{
+    hilosForzados = n > 0 ? n : 0;
+}
+
+int poolResolverHilos(int numHilos)
+{
+    return numHilos > 0 ? numHilos : poolHilosPorDefecto();
+}
+
+int poolIniciar(int numHilos)
+{
+    pthread_mutex_lock(&pool.envio);
+    if (pool.iniciado)
+    {
+        pthread_mutex_unlock(&pool.envio);
+        return 1;
+    }
+
+    numHilos = poolResolverHilos(numHilos);
+
+    // El hilo que llama también trabaja, así que se crean numHilos - 1
+    pool.hilos = (pthread_t *)malloc((size_t)numHilos * sizeof(pthread_t));
+    pool.colas = (ColaTeselas *)malloc((size_t)numHilos * sizeof(ColaTeselas));
+    if (!pool.hilos || !pool.colas)
+    {
+        fprintf(stderr, "Error de memoria al crear el pool de hilos\n");
+        free(pool.hilos);
+        free(pool.colas);
+        pool.hilos = NULL;
+        pool.colas = NULL;
+        pthread_mutex_unlock(&pool.envio);
+        return 0;
+    }
+    for (int i = 0; i < numHilos; i++)
+        pthread_mutex_init(&pool.colas[i].mutex, NULL);
+    pool.salir = 0;
+    pool.numTrabajadores = 0;
+    for (int i = 0; i < numHilos - 1; i++)
+    {
+        if (pthread_create(&pool.hilos[i], NULL, trabajadorPool, NULL) != 0)
+        {
+            fprintf(stderr, "Error al crear hilo %d del pool\n", i);
+            break;
+        }
+        pool.numTrabajadores++;
+    }
+    pool.iniciado = 1;
+    pthread_mutex_unlock(&pool.envio);
+    return 1;
+}
+
+void poolDestruir(void)
+{
+    pthread_mutex_lock(&pool.envio);
+    if (!pool.iniciado)
+    {
+        pthread_mutex_unlock(&pool.envio);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.mutex);
+    pool.salir = 1;
+    pthread_cond_broadcast(&pool.hayTrabajo);
+    pthread_mutex_unlock(&pool.mutex);
+
+    for (int i = 0; i < pool.numTrabajadores; i++)
+        pthread_join(pool.hilos[i], NULL);
+    for (int i = 0; i <= pool.numTrabajadores; i++)
+        pthread_mutex_destroy(&pool.colas[i].mutex);
+    free(pool.hilos);
+    free(pool.colas);
+    pool.hilos = NULL;
+    pool.colas = NULL;
+    pool.numTrabajadores = 0;
+    pool.iniciado = 0;
+    pthread_mutex_unlock(&pool.envio);
+}
+
+int poolNumHilos(void)
+{
+    return pool.iniciado ? pool.numTrabajadores + 1 : 1;
+}
+
+int poolFilasPorTesela(size_t bytesPorFila)
+{
+    if (bytesPorFila == 0 || bytesPorFila >= BYTES_POR_TESELA)
+        return 1;
+    return (int)(BYTES_POR_TESELA / bytesPorFila);
+}
+
+void poolParaleloForTeselas(int total, int numHilos, int filasPorTesela, TareaRango tarea, void *ctx)
+{
+    if (total <= 0)
+        return;
+    numHilos = poolResolverHilos(numHilos);
+
+    // Sin paralelismo posible: ejecutar en el hilo actual
+    if (numHilos <= 1 || total == 1 || esHiloDelPool || !poolIniciar(0) ||
+        pool.numTrabajadores == 0)
+    {
+        tarea(ctx, 0, total);
+        return;
+    }
+
+    int participantes = numHilos < pool.numTrabajadores + 1 ? numHilos : pool.numTrabajadores + 1;
+    if (participantes > total)
+        participantes = total;
+
+    // Teselas del tamaño pedido, pero al menos una por participante
+    if (filasPorTesela <= 0)
+        filasPorTesela = total / (participantes * TESELAS_POR_HILO);
+    int maximo = (total + participantes - 1) / participantes;
+    if (filasPorTesela > maximo)
+        filasPorTesela = maximo;
+    if (filasPorTesela < 1)
+        filasPorTesela = 1;
+    int numTeselas = (total + filasPorTesela - 1) / filasPorTesela;
+
+    pthread_mutex_lock(&pool.envio);
+
+    // Cada participante empieza con un bloque contiguo de teselas
+    for (int p = 0; p < participantes; p++)
+    {
+        pool.colas[p].inicio = (int)((long long)numTeselas * p / participantes);
+        pool.colas[p].fin = (int)((long long)numTeselas * (p + 1) / participantes);
+    }
+
+    pthread_mutex_lock(&pool.mutex);
+    pool.tarea = tarea;
+    pool.ctx = ctx;
+    pool.total = total;
+    pool.filasPorTesela = filasPorTesela;
+    pool.numParticipantes = participantes;
+    pool.siguienteId = 1; // la cola 0 es del hilo que envía
+    pool.activos = 1;
+    pool.abierto = 1;
+    pool.generacion++;
+    pthread_cond_broadcast(&pool.hayTrabajo);
+    pthread_mutex_unlock(&pool.mutex);
+
+    // El hilo que envía también procesa teselas y luego espera al resto
+    participar(0);
+    pthread_mutex_lock(&pool.mutex);
+    while (pool.activos > 0)
+        pthread_cond_wait(&pool.terminado, &pool.mutex);
+    pthread_mutex_unlock(&pool.mutex);
+    pthread_mutex_unlock(&pool.envio);
+}
+
+void poolParaleloFor(int total, int numHilos, TareaRango tarea, void *ctx)
+{
+    poolParaleloForTeselas(total, numHilos, 0, tarea, ctx);
+}
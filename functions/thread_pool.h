@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Pool de hilos persistente compartido por todas las operaciones.
+// Se crea una vez al inicio del programa; cada operación reparte su trabajo
+// en teselas (rangos de filas) con poolParaleloFor en lugar de crear y unir
+// hilos.
+
+#include <stddef.h>
+
+// Variable de entorno que fija el número de hilos por defecto
+#define POOL_VARIABLE_HILOS "IMG_HILOS"
+
+// Tarea que procesa el rango de filas [inicio, fin) usando el contexto ctx
+typedef void (*TareaRango)(void *ctx, int inicio, int fin);
+
+// Número de hilos a usar cuando una operación no pide uno concreto.
+// Prioridad: poolFijarHilosPorDefecto (flag -j), variable IMG_HILOS y por
+// último las CPUs disponibles según la afinidad del proceso.
+int poolHilosPorDefecto(void);
+
+// Lee un número de hilos (-j o IMG_HILOS): entero decimal completo, sin
+// texto de más, entre 1 e INT_MAX. Devuelve 0 si no es válido.
+int poolLeerHilos(const char *texto, int *n);
+
+// Fija el número de hilos por defecto (n <= 0 vuelve a la detección automática).
+void poolFijarHilosPorDefecto(int n);
+
+// Devuelve numHilos si es positivo, o poolHilosPorDefecto() en otro caso.
+int poolResolverHilos(int numHilos);
+
+// Crea el pool global con numHilos hilos (contando al hilo que llama);
+// numHilos <= 0 usa poolHilosPorDefecto(). Si ya existe no hace nada.
+// Devuelve 1 si el pool queda disponible.
+int poolIniciar(int numHilos);
+
+// Detiene y une los hilos del pool.
+void poolDestruir(void);
+
+// Número de hilos que ejecutan trabajo (trabajadores + hilo que llama).
+int poolNumHilos(void);
+
+// Filas por tesela para que una tesela de filas de bytesPorFila bytes quepa
+// en la caché (al menos 1).
+int poolFilasPorTesela(size_t bytesPorFila);
+
+// Corta [0, total) en teselas de filasPorTesela filas (<= 0: reparto por
+// defecto) y las ejecuta con hasta numHilos hilos del pool (<= 0: valor por
+// defecto). Cada hilo empieza con un bloque contiguo de teselas; al vaciar el
+// suyo roba la mitad del bloque pendiente de otro, así un hilo lento o
+// interrumpido no retrasa al resto. Bloquea hasta que todas terminan. Si el
+// pool no está disponible, ejecuta el trabajo en el hilo que llama.
+void poolParaleloForTeselas(int total, int numHilos, int filasPorTesela, TareaRango tarea, void *ctx);
+
+// poolParaleloForTeselas con el tamaño de tesela por defecto.
+void poolParaleloFor(int total, int numHilos, TareaRango tarea, void *ctx);
+
+#endif // THREAD_POOL_H
@@ -1,128 +1,114 @@
 // Programa de procesamiento de imágenes en C para principiantes en Linux.
 // QUÉ: Procesa imágenes PNG (escala de grises o RGB) usando matrices, con soporte
 // para carga, visualización, guardado y ajuste de brillo concurrente.
-// CÓMO: Usa stb_image.h para cargar PNG y stb_image_write.h para guardar PNG,
-// con hilos POSIX (pthread) para el procesamiento paralelo del brillo.
+// CÓMO: Usa stb_image.h para cargar PNG y functions/png_writer.c para guardar
+// PNG, con hilos POSIX (pthread) para el procesamiento paralelo del brillo.
 // POR QUÉ: Diseñado para enseñar manejo de matrices, concurrencia y gestión de
 // memoria en C, manteniendo simplicidad y robustez para principiantes.
-// Dependencias: Descarga stb_image.h y stb_image_write.h desde
-// https://github.com/nothings/stb
+// Dependencias: Descarga stb_image.h desde https://github.com/nothings/stb
 //   wget https://raw.githubusercontent.com/nothings/stb/master/stb_image.h
-//   wget https://raw.githubusercontent.com/nothings/stb/master/stb_image_write.h
 //
 // Compilar: gcc -o img img_base.c -pthread -lm
-// Ejecutar: ./img [ruta_imagen.png]
+// Ejecutar: ./img [-j hilos] [ruta_imagen.png]
+//           ./img -i entrada.png -o salida.png --op blur:k=7,s=2 --op sobel [-j hilos]
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
+#include <limits.h>
 
-// QUÉ: Incluir bibliotecas stb para cargar y guardar imágenes PNG.
-// CÓMO: stb_image.h lee PNG/JPG a memoria; stb_image_write.h escribe PNG.
-// POR QUÉ: Son bibliotecas de un solo archivo, simples y sin dependencias externas.
+// QUÉ: Incluir la biblioteca stb para cargar imágenes.
+// CÓMO: stb_image.h lee PNG/JPG a memoria; el PNG se escribe con
+// guardarPNGFilas (functions/png_writer.h), por filas y en paralelo.
+// POR QUÉ: Es una biblioteca de un solo archivo, simple y sin dependencias externas.
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
 
 // Include function headers
+#include "functions/imagen_info.h"
+#include "functions/brightness.h"
+#include "functions/png_writer.h"
 #include "functions/border.h"
 #include "functions/convolution.h"
 #include "functions/resize.h"
 #include "functions/rotation.h"
+#include "functions/flip.h"
+#include "functions/grafo.h"
+#include "functions/point.h"
+#include "functions/stream.h"
+#include "functions/thread_pool.h"
 
 // QUÉ: Estructura para almacenar la imagen (ancho, alto, canales, píxeles).
-// CÓMO: Usa matriz 3D para píxeles (alto x ancho x canales), donde canales es
-// 1 (grises) o 3 (RGB). Píxeles son unsigned char (0-255).
-// POR QUÉ: Permite manejar tanto grises como color, con memoria dinámica para
-// flexibilidad y evitar desperdicio.
-
-// QUÉ: Liberar memoria asignada para la imagen.
-// CÓMO: Libera cada fila y canal de la matriz 3D, luego el arreglo de filas y
-// reinicia la estructura.
-// POR QUÉ: Evita fugas de memoria, esencial en C para manejar recursos manualmente.
-void liberarImagen(ImagenInfo *info)
-{
-    if (info->pixeles)
-    {
-        for (int y = 0; y < info->alto; y++)
-        {
-            for (int x = 0; x < info->ancho; x++)
-            {
-                free(info->pixeles[y][x]); // Liberar canales por píxel
-            }
-            free(info->pixeles[y]); // Liberar fila
-        }
-        free(info->pixeles); // Liberar arreglo de filas
-        info->pixeles = NULL;
-    }
-    info->ancho = 0;
-    info->alto = 0;
-    info->canales = 0;
-}
+// CÓMO: Un único buffer contiguo (alto x ancho x canales) más un puntero por
+// fila, donde canales es 1 (grises) o 3 (RGB). Píxeles son unsigned char (0-255).
+// Al cargar, el buffer es directamente el que devuelve stb_image.
+// POR QUÉ: Una sola reserva en lugar de una por píxel: menos memoria, menos
+// llamadas a malloc y recorridos lineales de la imagen. Ver functions/imagen_info.h.
+
+// QUÉ: Límite de bytes de una imagen decodificada con stb_image.
+// CÓMO: stb_image calcula ancho * alto * canales en int.
+// POR QUÉ: Por encima hay que ir por franjas (PNM con --stream).
+#define BYTES_MAXIMOS_CARGA ((size_t)0x7FFFFFFF)
 
 // QUÉ: Cargar una imagen PNG desde un archivo.
-// CÓMO: Usa stbi_load para leer el archivo, detecta canales (1 o 3), y convierte
-// los datos a una matriz 3D (alto x ancho x canales).
-// POR QUÉ: La matriz 3D es intuitiva para principiantes y permite procesar
-// píxeles y canales individualmente.
+// CÓMO: Consulta los canales del archivo con stbi_info, pide a stbi_load
+// directamente 1 canal (grises, grises+alfa) o 3 (RGB, RGBA) y adopta ese
+// buffer como almacenamiento de la imagen, sin copiarlo.
+// POR QUÉ: La carga queda en la pura decodificación: sin una segunda pasada
+// por toda la imagen ni el doble de memoria en el pico.
 int cargarImagen(const char *ruta, ImagenInfo *info)
 {
-    int canales;
-    // QUÉ: Cargar imagen con formato original (0 canales = usar formato nativo).
-    // CÓMO: stbi_load lee el archivo y llena ancho, alto y canales.
+    int ancho, alto, canales;
+    // QUÉ: Averiguar el formato original sin decodificar.
+    // CÓMO: stbi_info lee solo la cabecera del archivo.
     // POR QUÉ: Respetar el formato original asegura que grises o RGB se mantengan.
-    unsigned char *datos = stbi_load(ruta, &info->ancho, &info->alto, &canales, 0);
-    if (!datos)
+    if (!stbi_info(ruta, &ancho, &alto, &canales))
     {
         fprintf(stderr, "Error al cargar imagen: %s\n", ruta);
         return 0;
     }
-    info->canales = (canales == 1 || canales == 3) ? canales : 1; // Forzar 1 o 3
+    int canalesDeseados = (canales == 1 || canales == 2) ? 1 : 3; // Forzar 1 o 3 (sin alfa)
 
-    // QUÉ: Asignar memoria para matriz 3D.
-    // CÓMO: Asignar alto filas, luego ancho columnas por fila, luego canales por píxel.
-    // POR QUÉ: Estructura clara y flexible para grises (1 canal) o RGB (3 canales).
-    info->pixeles = (unsigned char ***)malloc(info->alto * sizeof(unsigned char **));
-    if (!info->pixeles)
+    // QUÉ: Comprobar el tamaño antes de decodificar.
+    // CÓMO: imagenTamanoValido calcula los bytes en size_t; stb_image calcula
+    // los suyos en int y no pasa de BYTES_MAXIMOS_CARGA.
+    // POR QUÉ: Una imagen enorme da un error claro en lugar de desbordar.
+    size_t bytes;
+    if (!imagenTamanoValido(ancho, alto, canalesDeseados, &bytes))
     {
-        fprintf(stderr, "Error de memoria al asignar filas\n");
-        stbi_image_free(datos);
+        fprintf(stderr, "Tamaño de imagen inválido (%dx%d): %s\n", ancho, alto, ruta);
         return 0;
     }
-    for (int y = 0; y < info->alto; y++)
+    if (bytes > BYTES_MAXIMOS_CARGA)
     {
-        info->pixeles[y] = (unsigned char **)malloc(info->ancho * sizeof(unsigned char *));
-        if (!info->pixeles[y])
-        {
-            fprintf(stderr, "Error de memoria al asignar columnas\n");
-            liberarImagen(info);
-            stbi_image_free(datos);
-            return 0;
-        }
-        for (int x = 0; x < info->ancho; x++)
-        {
-            info->pixeles[y][x] = (unsigned char *)malloc(info->canales * sizeof(unsigned char));
-            if (!info->pixeles[y][x])
-            {
-                fprintf(stderr, "Error de memoria al asignar canales\n");
-                liberarImagen(info);
-                stbi_image_free(datos);
-                return 0;
-            }
-            // Copiar píxeles a matriz 3D
-            for (int c = 0; c < info->canales; c++)
-            {
-                info->pixeles[y][x][c] = datos[(y * info->ancho + x) * info->canales + c];
-            }
-        }
+        fprintf(stderr, "Imagen demasiado grande para cargarla entera (%dx%d, %zu MB): %s\n"
+                        "Se puede procesar como PNM (P5/P6) en el modo lote con --stream.\n",
+                ancho, alto, bytes >> 20, ruta);
+        return 0;
+    }
+
+    unsigned char *datos = stbi_load(ruta, &ancho, &alto, &canales, canalesDeseados);
+    if (!datos)
+    {
+        fprintf(stderr, "Error al cargar imagen: %s\n", ruta);
+        return 0;
     }
 
-    stbi_image_free(datos); // Liberar buffer de stb
-    printf("Imagen cargada: %dx%d, %d canales (%s)\n", info->ancho, info->alto,
-           info->canales, info->canales == 1 ? "grises" : "RGB");
+    // QUÉ: Usar el buffer de stb como datos de la imagen.
+    // CÓMO: adoptarBuffer crea solo los punteros a filas; liberarImagen
+    // devolverá el buffer con stbi_image_free.
+    // POR QUÉ: Evita reservar y copiar una segunda imagen completa.
+    if (!adoptarBuffer(info, datos, ancho, alto, canalesDeseados, stbi_image_free))
+    {
+        stbi_image_free(datos);
+        return 0;
+    }
+
+    IMG_INFO("Imagen cargada: %dx%d, %d canales (%s)\n", info->ancho, info->alto,
+             info->canales, info->canales == 1 ? "grises" : "RGB");
     return 1;
 }
 
@@ -143,12 +129,12 @@ void mostrarMatriz(const ImagenInfo *info)
         {
             if (info->canales == 1)
             {
-                printf("%3u ", info->pixeles[y][x][0]); // Escala de grises
+                printf("%3u ", info->pixeles[y][x]); // Escala de grises
             }
             else
             {
-                printf("(%3u,%3u,%3u) ", info->pixeles[y][x][0], info->pixeles[y][x][1],
-                       info->pixeles[y][x][2]); // RGB
+                const unsigned char *p = IMG_PIXEL(info, y, x);
+                printf("(%3u,%3u,%3u) ", p[0], p[1], p[2]); // RGB
             }
         }
         printf("\n");
@@ -159,9 +145,12 @@ void mostrarMatriz(const ImagenInfo *info)
     }
 }
 
-// QUÉ: Guardar la matriz como PNG (grises o RGB).
-// CÓMO: Aplana la matriz 3D a 1D y usa stbi_write_png con el número de canales correcto.
-// POR QUÉ: Respeta el formato original (grises o RGB) para consistencia.
+// QUÉ: Guardar la imagen como PNG (grises o RGB).
+// CÓMO: guardarPNGFilas lee las filas directamente por sus punteros, las
+// filtra y comprime por tramos en el pool de hilos y escribe los chunks a
+// medida que termina cada tramo.
+// POR QUÉ: No hace falta copia completa de la imagen (contigua o no), y el
+// guardado de imágenes grandes aprovecha todos los núcleos.
 int guardarPNG(const ImagenInfo *info, const char *rutaSalida)
 {
     if (!info->pixeles)
@@ -170,121 +159,676 @@ int guardarPNG(const ImagenInfo *info, const char *rutaSalida)
         return 0;
     }
 
-    // QUÉ: Aplanar matriz 3D a 1D para stb.
-    // CÓMO: Copia píxeles en orden [y][x][c] a un arreglo plano.
-    // POR QUÉ: stb_write_png requiere datos contiguos.
-    unsigned char *datos1D = (unsigned char *)malloc(info->ancho * info->alto * info->canales);
-    if (!datos1D)
+    // QUÉ: Guardar como PNG.
+    // CÓMO: Usa los canales de la imagen original.
+    // POR QUÉ: Mantiene el formato (grises o RGB) de la entrada.
+    int resultado = guardarPNGFilas(rutaSalida, info->pixeles, info->ancho, info->alto, info->canales);
+    if (resultado)
     {
-        fprintf(stderr, "Error de memoria al aplanar imagen\n");
+        IMG_INFO("Imagen guardada en: %s (%s)\n", rutaSalida,
+                 info->canales == 1 ? "grises" : "RGB");
+        return 1;
+    }
+    else
+    {
+        fprintf(stderr, "Error al guardar PNG: %s\n", rutaSalida);
         return 0;
     }
-    for (int y = 0; y < info->alto; y++)
+}
+
+// QUÉ: Operaciones que acepta el modo lote (--op nombre:parámetros).
+// CÓMO: Cada --op se traduce a un OperacionLote y se aplica en orden.
+// POR QUÉ: Permite encadenar operaciones sin pasar por el menú interactivo.
+typedef enum
+{
+    OP_BRILLO,
+    OP_DESENFOQUE,
+    OP_SOBEL,
+    OP_RESIZE,
+    OP_ROTAR,
+    OP_VOLTEAR,
+    OP_TRANSPONER,
+    OP_CONTRASTE,
+    OP_GAMMA,
+    OP_NIVELES,
+    OP_INVERTIR,
+    OP_UMBRAL,
+    OP_CURVA,
+    OP_KERNEL,
+    OP_GRISES
+} TipoOperacion;
+
+#define MAX_PUNTOS_CURVA 16
+
+typedef struct
+{
+    TipoOperacion tipo;
+    int delta;     // brightness
+    int tamKernel; // blur
+    float sigma;   // blur
+    int ancho;     // resize
+    int alto;      // resize
+    int filtro;    // resize: -1 = bilineal, si no un FiltroResize
+    float angulo;  // rotate
+    unsigned char fondo[3]; // rotate: color RGB de las esquinas
+    char eje;               // flip: 'h' o 'v'
+    float factor;           // contrast: factor; gamma, levels: gamma
+    int negro, blanco;      // levels; threshold usa negro como umbral
+    int canal;              // curve: canal (-1 = todos)
+    int numPuntos;          // curve
+    int curvaX[MAX_PUNTOS_CURVA], curvaY[MAX_PUNTOS_CURVA];
+    char nombreKernel[16];  // kernel: predefinido (tamKernel = lado de box)
+    KernelUsuario kernel;   // kernel: pesos ya leídos
+} OperacionLote;
+
+// QUÉ: Leer un entero o real completo desde texto.
+// CÓMO: strtol/strtof y comprobar que se consumió toda la cadena.
+// POR QUÉ: Rechaza valores como "7x" o "" en lugar de tomarlos como 0, los
+// que no caben en int (en vez de truncarlos), e "inf" o "nan", que ninguna
+// operación sabe usar.
+static int leerEntero(const char *texto, int *valor)
+{
+    char *fin;
+    errno = 0;
+    long v = strtol(texto, &fin, 10);
+    if (fin == texto || *fin != '\0' || errno == ERANGE || v < INT_MIN || v > INT_MAX)
+        return 0;
+    *valor = (int)v;
+    return 1;
+}
+
+static int leerReal(const char *texto, float *valor)
+{
+    char *fin;
+    float v = strtof(texto, &fin);
+    if (fin == texto || *fin != '\0' || !isfinite(v))
+        return 0;
+    *valor = v;
+    return 1;
+}
+
+// Color "RRGGBB" en hexadecimal (p. ej. ffffff = blanco)
+static int leerColor(const char *texto, unsigned char rgb[3])
+{
+    if (strlen(texto) != 6 || strspn(texto, "0123456789abcdefABCDEF") != 6)
+        return 0;
+    unsigned long v = strtoul(texto, NULL, 16);
+    rgb[0] = (unsigned char)(v >> 16);
+    rgb[1] = (unsigned char)(v >> 8);
+    rgb[2] = (unsigned char)v;
+    return 1;
+}
+
+// QUÉ: Interpretar una especificación "nombre:clave=valor,clave=valor".
+// CÓMO: Separa el nombre, luego recorre los parámetros separados por comas.
+// Un valor sin clave se toma como el parámetro principal de la operación.
+// POR QUÉ: Formato compacto para la línea de comandos, p. ej. blur:k=7,s=2.
+static int parsearOperacion(const char *spec, OperacionLote *op)
+{
+    char copia[256];
+    strncpy(copia, spec, sizeof(copia) - 1);
+    copia[sizeof(copia) - 1] = '\0';
+
+    char *params = strchr(copia, ':');
+    if (params)
+        *params++ = '\0';
+
+    memset(op, 0, sizeof(*op));
+    if (strcmp(copia, "brightness") == 0)
+        op->tipo = OP_BRILLO;
+    else if (strcmp(copia, "blur") == 0)
     {
-        for (int x = 0; x < info->ancho; x++)
+        op->tipo = OP_DESENFOQUE;
+        op->tamKernel = 5;
+        op->sigma = 1.0f;
+    }
+    else if (strcmp(copia, "sobel") == 0)
+        op->tipo = OP_SOBEL;
+    else if (strcmp(copia, "resize") == 0)
+        op->tipo = OP_RESIZE;
+    else if (strcmp(copia, "rotate") == 0)
+        op->tipo = OP_ROTAR;
+    else if (strcmp(copia, "flip") == 0)
+        op->tipo = OP_VOLTEAR;
+    else if (strcmp(copia, "transpose") == 0)
+        op->tipo = OP_TRANSPONER;
+    else if (strcmp(copia, "contrast") == 0)
+        op->tipo = OP_CONTRASTE;
+    else if (strcmp(copia, "gamma") == 0)
+        op->tipo = OP_GAMMA;
+    else if (strcmp(copia, "levels") == 0)
+    {
+        op->tipo = OP_NIVELES;
+        op->blanco = 255;
+        op->factor = 1.0f;
+    }
+    else if (strcmp(copia, "invert") == 0)
+        op->tipo = OP_INVERTIR;
+    else if (strcmp(copia, "threshold") == 0)
+        op->tipo = OP_UMBRAL;
+    else if (strcmp(copia, "curve") == 0)
+    {
+        op->tipo = OP_CURVA;
+        op->canal = -1;
+    }
+    else if (strcmp(copia, "kernel") == 0)
+    {
+        op->tipo = OP_KERNEL;
+        op->tamKernel = 3;
+    }
+    else if (strcmp(copia, "gray") == 0)
+        op->tipo = OP_GRISES;
+    else
+    {
+        fprintf(stderr, "Operación desconocida: %s\n", spec);
+        return 0;
+    }
+
+    // resize:ANCHOxALTO[,f=FILTRO]
+    if (op->tipo == OP_RESIZE)
+    {
+        op->filtro = -1;
+        char *coma = params ? strchr(params, ',') : NULL;
+        if (coma)
         {
-            for (int c = 0; c < info->canales; c++)
+            *coma = '\0';
+            if (strncmp(coma + 1, "f=", 2) != 0 || (op->filtro = filtroResizePorNombre(coma + 3)) < 0)
             {
-                datos1D[(y * info->ancho + x) * info->canales + c] = info->pixeles[y][x][c];
+                fprintf(stderr, "Filtro inválido en: %s (box, triangle, catmull-rom, lanczos3)\n", spec);
+                return 0;
             }
         }
+        char *x = params ? strchr(params, 'x') : NULL;
+        if (!x)
+        {
+            fprintf(stderr, "resize requiere ANCHOxALTO: %s\n", spec);
+            return 0;
+        }
+        *x = '\0';
+        if (!leerEntero(params, &op->ancho) || !leerEntero(x + 1, &op->alto) ||
+            op->ancho <= 0 || op->alto <= 0)
+        {
+            fprintf(stderr, "Tamaño inválido en: %s\n", spec);
+            return 0;
+        }
+        return 1;
     }
 
-    // QUÉ: Guardar como PNG.
-    // CÓMO: Usa stbi_write_png con los canales de la imagen original.
-    // POR QUÉ: Mantiene el formato (grises o RGB) de la entrada.
-    int resultado = stbi_write_png(rutaSalida, info->ancho, info->alto, info->canales,
-                                   datos1D, info->ancho * info->canales);
-    free(datos1D);
-    if (resultado)
+    int tienePrincipal = 0;
+    for (char *tok = params ? strtok(params, ",") : NULL; tok; tok = strtok(NULL, ","))
+    {
+        char *igual = strchr(tok, '=');
+        const char *clave = igual ? tok : "";
+        const char *valor = igual ? igual + 1 : tok;
+        if (igual)
+            *igual = '\0';
+
+        int ok = 0, esPrincipal = 1;
+        switch (op->tipo)
+        {
+        case OP_BRILLO:
+            if (!igual || strcmp(clave, "d") == 0)
+                ok = leerEntero(valor, &op->delta);
+            break;
+        case OP_DESENFOQUE:
+            if (!igual || strcmp(clave, "k") == 0)
+                ok = leerEntero(valor, &op->tamKernel);
+            else if (strcmp(clave, "s") == 0)
+                ok = leerReal(valor, &op->sigma);
+            break;
+        case OP_ROTAR:
+            if (!igual || strcmp(clave, "a") == 0)
+                ok = leerReal(valor, &op->angulo);
+            else if (strcmp(clave, "bg") == 0)
+            {
+                ok = leerColor(valor, op->fondo);
+                esPrincipal = 0; // el fondo solo no basta
+            }
+            break;
+        case OP_VOLTEAR:
+            if ((!igual || strcmp(clave, "eje") == 0) && (strcmp(valor, "h") == 0 || strcmp(valor, "v") == 0))
+            {
+                op->eje = valor[0];
+                ok = 1;
+            }
+            break;
+        case OP_CONTRASTE:
+            if (!igual || strcmp(clave, "f") == 0)
+                ok = leerReal(valor, &op->factor) && op->factor >= 0.0f;
+            break;
+        case OP_GAMMA:
+            if (!igual || strcmp(clave, "g") == 0)
+                ok = leerReal(valor, &op->factor) && op->factor > 0.0f;
+            break;
+        case OP_NIVELES:
+            if (strcmp(clave, "n") == 0)
+                ok = leerEntero(valor, &op->negro);
+            else if (strcmp(clave, "b") == 0)
+                ok = leerEntero(valor, &op->blanco);
+            else if (strcmp(clave, "g") == 0)
+                ok = leerReal(valor, &op->factor) && op->factor > 0.0f;
+            break;
+        case OP_UMBRAL:
+            if (!igual || strcmp(clave, "t") == 0)
+                ok = leerEntero(valor, &op->negro);
+            break;
+        case OP_CURVA:
+            // Puntos "x/y"; c=0|1|2 limita la curva a un canal
+            if (igual && strcmp(clave, "c") == 0)
+            {
+                ok = leerEntero(valor, &op->canal) && op->canal >= 0 && op->canal < 3;
+                esPrincipal = 0;
+            }
+            else if (!igual && op->numPuntos < MAX_PUNTOS_CURVA)
+            {
+                char *barra = strchr(tok, '/');
+                if (barra)
+                {
+                    *barra = '\0';
+                    ok = leerEntero(tok, &op->curvaX[op->numPuntos]) &&
+                         leerEntero(barra + 1, &op->curvaY[op->numPuntos]);
+                    *barra = '/';
+                    op->numPuntos++;
+                }
+            }
+            break;
+        case OP_KERNEL:
+            // Un nombre predefinido, w=pesos o file=ruta; k=K es el lado de box
+            if (igual && strcmp(clave, "k") == 0)
+            {
+                ok = leerEntero(valor, &op->tamKernel);
+                esPrincipal = 0;
+            }
+            else if (!igual && strlen(valor) < sizeof(op->nombreKernel))
+            {
+                strcpy(op->nombreKernel, valor);
+                ok = 1;
+            }
+            else if (igual && strcmp(clave, "w") == 0)
+                ok = leerKernelTexto(valor, &op->kernel);
+            else if (igual && strcmp(clave, "file") == 0)
+                ok = leerKernelArchivo(valor, &op->kernel);
+            break;
+        default:
+            break;
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "Parámetro inválido '%s%s%s' en: %s\n", clave, igual ? "=" : "", valor, spec);
+            return 0;
+        }
+        if (esPrincipal)
+            tienePrincipal = 1;
+    }
+
+    if ((op->tipo == OP_BRILLO || op->tipo == OP_ROTAR || op->tipo == OP_VOLTEAR || op->tipo == OP_CONTRASTE ||
+         op->tipo == OP_GAMMA || op->tipo == OP_UMBRAL || op->tipo == OP_CURVA || op->tipo == OP_KERNEL) &&
+        !tienePrincipal)
+    {
+        fprintf(stderr, "Falta el valor de la operación: %s\n", spec);
+        return 0;
+    }
+    if (op->tipo == OP_KERNEL && op->nombreKernel[0])
+        return kernelPorNombre(op->nombreKernel, op->tamKernel, &op->kernel);
+    return 1;
+}
+
+static int componerPuntual(LutPuntual *lut, const OperacionLote *op)
+{
+    switch (op->tipo)
     {
-        printf("Imagen guardada en: %s (%s)\n", rutaSalida,
-               info->canales == 1 ? "grises" : "RGB");
+    case OP_BRILLO:
+        lutBrillo(lut, op->delta);
         return 1;
+    case OP_CONTRASTE:
+        lutContraste(lut, op->factor);
+        return 1;
+    case OP_GAMMA:
+        lutGamma(lut, op->factor);
+        return 1;
+    case OP_NIVELES:
+        if (!lutNiveles(lut, op->negro, op->blanco, op->factor))
+        {
+            fprintf(stderr, "levels: se necesita 0 <= n < b <= 255 y g > 0\n");
+            return 0;
+        }
+        return 1;
+    case OP_INVERTIR:
+        lutInvertir(lut);
+        return 1;
+    case OP_UMBRAL:
+        lutUmbral(lut, op->negro);
+        return 1;
+    case OP_CURVA:
+        if (!lutCurva(lut, op->canal, op->curvaX, op->curvaY, op->numPuntos))
+        {
+            fprintf(stderr, "curve: puntos x/y en [0, 255] con x creciente\n");
+            return 0;
+        }
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// QUÉ: Encolar una operación del lote en el grafo.
+// CÓMO: Cada operación puntual se encola como su tabla de consulta; el
+// resto con su función grafo* (no se ejecuta nada todavía).
+// POR QUÉ: El planificador del grafo ve la cadena entera y funde lo que
+// puede antes de tocar la imagen.
+static int encolarOperacion(GrafoOperaciones *grafo, const OperacionLote *op)
+{
+    switch (op->tipo)
+    {
+    case OP_BRILLO:
+        return grafoBrillo(grafo, op->delta);
+    case OP_DESENFOQUE:
+        return grafoDesenfoque(grafo, op->tamKernel, op->sigma);
+    case OP_SOBEL:
+        return grafoSobel(grafo);
+    case OP_RESIZE:
+        return grafoResize(grafo, op->ancho, op->alto, op->filtro);
+    case OP_ROTAR:
+        return grafoRotar(grafo, op->angulo, op->fondo);
+    case OP_VOLTEAR:
+        return grafoVoltear(grafo, op->eje);
+    case OP_TRANSPONER:
+        return grafoTransponer(grafo);
+    case OP_KERNEL:
+        return grafoKernel(grafo, op->kernel.pesos, op->kernel.tam);
+    case OP_GRISES:
+        return grafoGrises(grafo);
+    default:
+    {
+        LutPuntual lut;
+        lutIdentidad(&lut);
+        return componerPuntual(&lut, op) && grafoLut(grafo, &lut);
     }
+    }
+}
+
+// QUÉ: Construir el grafo de la cadena de operaciones del lote.
+// CÓMO: Encola las operaciones en el orden de la línea de comandos.
+// POR QUÉ: Se construye una vez y se ejecuta sobre cada entrada.
+static GrafoOperaciones *construirGrafo(const OperacionLote *ops, int numOps)
+{
+    GrafoOperaciones *grafo = grafoCrear();
+    if (!grafo)
+    {
+        fprintf(stderr, "Error de memoria al crear el grafo de operaciones\n");
+        return NULL;
+    }
+    for (int o = 0; o < numOps; o++)
+    {
+        if (!encolarOperacion(grafo, &ops[o]))
+        {
+            grafoLiberar(grafo);
+            return NULL;
+        }
+    }
+    return grafo;
+}
+
+// QUÉ: Procesar una entrada en modo --stream.
+// CÓMO: Un PNM (P5/P6) se lee del disco franja a franja; los demás formatos
+// se decodifican completos con stb_image (no decodifica por partes) y solo
+// el procesamiento y la escritura van por franjas.
+// POR QUÉ: Con PNM la memoria queda acotada aunque la imagen no quepa en RAM.
+static int procesarEntradaPorFranjas(const char *entrada, const char *ruta, const GrafoOperaciones *grafo)
+{
+    FuenteFranjas fuente;
+    ImagenInfo imagen = {0};
+    int ok;
+    if (archivoEsPNM(entrada))
+        ok = fuenteAbrirPNM(&fuente, entrada);
     else
     {
-        fprintf(stderr, "Error al guardar PNG: %s\n", rutaSalida);
-        return 0;
+        ok = cargarImagen(entrada, &imagen);
+        if (ok)
+            fuenteDesdeImagen(&fuente, &imagen);
     }
+    if (ok)
+    {
+        ok = grafoProcesarPorFranjas(grafo, &fuente, ruta, 0);
+        fuenteCerrar(&fuente);
+    }
+    liberarImagen(&imagen);
+    return ok;
 }
 
-// QUÉ: Estructura para pasar datos al hilo de ajuste de brillo.
-// CÓMO: Contiene matriz, rango de filas, ancho, canales y delta de brillo.
-// POR QUÉ: Los hilos necesitan datos específicos para procesar en paralelo.
-typedef struct
+// QUÉ: Saber si una entrada solo se puede procesar por franjas.
+// CÓMO: Lee la cabecera de un PNM (sin mensajes: cualquier otro archivo,
+// p. ej. un PNM de 16 bits, lo carga stb_image) y compara sus bytes con el
+// límite de carga.
+// POR QUÉ: Un PNM más grande de lo que stb_image decodifica pasa al modo
+// --stream automáticamente en lugar de fallar al cargar.
+static int necesitaFranjas(const char *ruta)
 {
-    unsigned char ***pixeles;
-    int inicio;
-    int fin;
-    int ancho;
-    int canales;
-    int delta;
-} BrilloArgs;
-
-// QUÉ: Ajustar brillo en un rango de filas (para hilos).
-// CÓMO: Suma delta a cada canal de cada píxel, con clamp entre 0-255.
-// POR QUÉ: Procesa píxeles en paralelo para demostrar concurrencia.
-void *ajustarBrilloHilo(void *args)
+    int ancho, alto, canales;
+    size_t bytes;
+    if (!cabeceraPNM(ruta, &ancho, &alto, &canales))
+        return 0;
+    return imagenTamanoValido(ancho, alto, canales, &bytes) && bytes > BYTES_MAXIMOS_CARGA;
+}
+
+// QUÉ: Construir la ruta de salida para una entrada cuando hay varias.
+// CÓMO: directorio + nombre base de la entrada con extensión .png.
+// POR QUÉ: Con varias entradas, -o indica un directorio de salida.
+static void rutaSalidaEnDirectorio(char *destino, size_t tam, const char *dir, const char *entrada)
 {
-    BrilloArgs *bArgs = (BrilloArgs *)args;
-    for (int y = bArgs->inicio; y < bArgs->fin; y++)
+    const char *base = strrchr(entrada, '/');
+    base = base ? base + 1 : entrada;
+    const char *punto = strrchr(base, '.');
+    int largo = punto ? (int)(punto - base) : (int)strlen(base);
+    size_t largoDir = strlen(dir);
+    const char *sep = (largoDir > 0 && dir[largoDir - 1] == '/') ? "" : "/";
+    snprintf(destino, tam, "%s%s%.*s.png", dir, sep, largo, base);
+}
+
+// QUÉ: Mostrar la ayuda del modo lote.
+static void mostrarUsoLote(const char *programa)
+{
+    fprintf(stderr,
+            "Uso: %s -i entrada [-i entrada ...] -o salida [--op operación ...] [-j hilos] [--stream]\n"
+            "  Con varias entradas, -o es un directorio y cada salida se llama como su entrada (.png).\n"
+            "  --stream procesa por franjas de filas con memoria acotada (entrada PNM P5/P6 leída\n"
+            "  por partes; no admite rotate, transpose, flip:v ni blur con filtro recursivo).\n"
+            "Operaciones (se aplican en el orden dado):\n"
+            "  brightness:d=N         sumar N al brillo (también brightness:N)\n"
+            "  blur:k=K,s=S           desenfoque Gaussiano, kernel impar K (0 = 2*ceil(3S)+1) y sigma S;\n"
+            "                         con S >= 4 y K = 0 (o K >= 2*ceil(3S)+1) se usa el filtro\n"
+            "                         recursivo (coste fijo); un K menor se respeta\n"
+            "  kernel:NOMBRE[,k=K]    convolución con un kernel predefinido: sharpen, emboss,\n"
+            "                         laplacian (3x3) o box (media de KxK, K impar)\n"
+            "  kernel:w=PESOS         kernel propio: N x N números (N impar) separados por\n"
+            "                         espacios o ';', con \"/D\" final opcional para dividir\n"
+            "  kernel:file=RUTA       kernel propio leído de un archivo (mismo formato, # comenta)\n"
+            "  sobel                  detección de bordes (salida en grises)\n"
+            "  resize:ANCHOxALTO      redimensionado bilineal\n"
+            "  resize:ANCHOxALTO,f=F  redimensionado separable con filtro F: box, triangle,\n"
+            "                         catmull-rom o lanczos3 (reduce sin aliasing en un paso)\n"
+            "  rotate:a=GRADOS[,bg=RRGGBB]\n"
+            "                         rotación horaria de cualquier ángulo (también\n"
+            "                         rotate:GRADOS); bg = color de fondo (000000)\n"
+            "  flip:h | flip:v        espejo horizontal o vertical, en el sitio\n"
+            "  transpose              transposición en el sitio (solo imágenes cuadradas)\n"
+            "  contrast:f=F           contraste alrededor de 128 (F > 1 aumenta)\n"
+            "  gamma:g=G              corrección gamma (G > 1 aclara los medios tonos)\n"
+            "  levels:n=N,b=B,g=G     niveles: [N, B] pasa a [0, 255] con gamma G\n"
+            "  invert                 negativo\n"
+            "  threshold:t=T          binarizar: 255 si v >= T, si no 0\n"
+            "  curve:[c=C,]X/Y,...    curva lineal a trozos (c = canal 0, 1 o 2)\n"
+            "  gray                   escala de grises (promedio de los tres canales)\n"
+            "  Las operaciones puntuales seguidas (brightness, contrast, gamma, levels,\n"
+            "  invert, threshold, curve) se funden en una sola pasada, que se aplica al\n"
+            "  leer las filas de la operación siguiente; gray antes de sobel se omite.\n",
+            programa);
+}
+
+// QUÉ: Modo lote no interactivo.
+// CÓMO: Lee -i/-o/--op/-j, construye una vez el grafo de operaciones y para
+// cada entrada carga, lo ejecuta y guarda, sin mensajes por consola salvo errores.
+// POR QUÉ: Permite usar el programa desde scripts y trabajos de producción.
+static int ejecutarLote(int argc, char *argv[])
+{
+    const char **entradas = (const char **)malloc((size_t)argc * sizeof(char *));
+    OperacionLote *ops = (OperacionLote *)malloc((size_t)argc * sizeof(OperacionLote));
+    int numEntradas = 0, numOps = 0;
+    const char *salida = NULL;
+    int porFranjas = 0;
+    int estado = EXIT_SUCCESS;
+
+    if (!entradas || !ops)
+    {
+        fprintf(stderr, "Error de memoria al leer argumentos\n");
+        free(entradas);
+        free(ops);
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 1; i < argc; i++)
     {
-        for (int x = 0; x < bArgs->ancho; x++)
+        const char *arg = argv[i];
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0)
+        {
+            mostrarUsoLote(argv[0]);
+            free(entradas);
+            free(ops);
+            return EXIT_SUCCESS;
+        }
+        if (strcmp(arg, "--stream") == 0)
+        {
+            porFranjas = 1;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            fprintf(stderr, "Falta el valor de %s\n", arg);
+            estado = EXIT_FAILURE;
+            break;
+        }
+        const char *valor = argv[++i];
+        if (strcmp(arg, "-i") == 0)
+            entradas[numEntradas++] = valor;
+        else if (strcmp(arg, "-o") == 0)
+            salida = valor;
+        else if (strcmp(arg, "--op") == 0)
         {
-            for (int c = 0; c < bArgs->canales; c++)
+            if (!parsearOperacion(valor, &ops[numOps++]))
             {
-                int nuevoValor = bArgs->pixeles[y][x][c] + bArgs->delta;
-                bArgs->pixeles[y][x][c] = (unsigned char)(nuevoValor < 0 ? 0 : (nuevoValor > 255 ? 255 : nuevoValor));
+                estado = EXIT_FAILURE;
+                break;
+            }
+        }
+        else if (strcmp(arg, "-j") == 0)
+        {
+            int n;
+            if (!poolLeerHilos(valor, &n))
+            {
+                fprintf(stderr, "Número de hilos inválido: %s\n", valor);
+                estado = EXIT_FAILURE;
+                break;
             }
+            poolFijarHilosPorDefecto(n);
+        }
+        else
+        {
+            fprintf(stderr, "Argumento desconocido: %s\n", arg);
+            estado = EXIT_FAILURE;
+            break;
         }
     }
-    return NULL;
-}
 
-// QUÉ: Ajustar brillo de la imagen usando múltiples hilos.
-// CÓMO: Divide las filas entre 2 hilos, pasa argumentos y espera con join.
-// POR QUÉ: Usa concurrencia para acelerar el procesamiento y enseñar hilos.
-void ajustarBrilloConcurrente(ImagenInfo *info, int delta)
-{
-    if (!info->pixeles)
+    if (estado == EXIT_SUCCESS && (numEntradas == 0 || !salida))
     {
-        printf("No hay imagen cargada.\n");
-        return;
+        mostrarUsoLote(argv[0]);
+        estado = EXIT_FAILURE;
+    }
+    GrafoOperaciones *grafo = NULL;
+    if (estado == EXIT_SUCCESS)
+    {
+        grafo = construirGrafo(ops, numOps);
+        if (!grafo)
+            estado = EXIT_FAILURE;
+        else if (porFranjas && !grafoAdmiteFranjas(grafo))
+        {
+            fprintf(stderr, "--stream no admite rotate, transpose, flip:v ni blur con filtro recursivo "
+                            "(S >= 4 y K = 0 o K >= 2*ceil(3S)+1)\n");
+            estado = EXIT_FAILURE;
+        }
+    }
+    if (estado != EXIT_SUCCESS)
+    {
+        grafoLiberar(grafo);
+        free(entradas);
+        free(ops);
+        return estado;
     }
 
-    const int numHilos = 2; // QUÉ: Número fijo de hilos para simplicidad.
-    pthread_t hilos[numHilos];
-    BrilloArgs args[numHilos];
-    int filasPorHilo = (int)ceil((double)info->alto / numHilos);
+    imagenModoSilencioso = 1;
+    poolIniciar(0);
 
-    // QUÉ: Configurar y lanzar hilos.
-    // CÓMO: Asigna rangos de filas a cada hilo y pasa datos.
-    // POR QUÉ: Divide el trabajo para procesar en paralelo.
-    for (int i = 0; i < numHilos; i++)
+    for (int e = 0; e < numEntradas; e++)
     {
-        args[i].pixeles = info->pixeles;
-        args[i].inicio = i * filasPorHilo;
-        args[i].fin = (i + 1) * filasPorHilo < info->alto ? (i + 1) * filasPorHilo : info->alto;
-        args[i].ancho = info->ancho;
-        args[i].canales = info->canales;
-        args[i].delta = delta;
-        if (pthread_create(&hilos[i], NULL, ajustarBrilloHilo, &args[i]) != 0)
+        char ruta[4096];
+        if (numEntradas > 1)
+            rutaSalidaEnDirectorio(ruta, sizeof(ruta), salida, entradas[e]);
+        else
+            snprintf(ruta, sizeof(ruta), "%s", salida);
+
+        // Un PNM que no cabe en una carga completa va siempre por franjas
+        const int franjas = porFranjas || necesitaFranjas(entradas[e]);
+        if (franjas && !grafoAdmiteFranjas(grafo))
         {
-            fprintf(stderr, "Error al crear hilo %d\n", i);
-            return;
+            fprintf(stderr, "Error procesando %s: demasiado grande para cargarla entera y la cadena no se "
+                            "puede aplicar por franjas (rotate, transpose, flip:v, blur recursivo)\n", entradas[e]);
+            estado = EXIT_FAILURE;
+            continue;
         }
+        if (franjas)
+        {
+            if (!procesarEntradaPorFranjas(entradas[e], ruta, grafo))
+            {
+                fprintf(stderr, "Error procesando %s\n", entradas[e]);
+                estado = EXIT_FAILURE;
+            }
+            continue;
+        }
+
+        ImagenInfo imagen = {0};
+        int ok = cargarImagen(entradas[e], &imagen);
+        if (ok)
+            ok = grafoEjecutar(grafo, &imagen, 0);
+        if (ok)
+            ok = guardarPNG(&imagen, ruta);
+        if (!ok)
+        {
+            fprintf(stderr, "Error procesando %s\n", entradas[e]);
+            estado = EXIT_FAILURE;
+        }
+        liberarImagen(&imagen);
     }
 
-    // QUÉ: Esperar a que los hilos terminen.
-    // CÓMO: Usa pthread_join para sincronizar.
-    // POR QUÉ: Garantiza que todos los píxeles se procesen antes de continuar.
-    for (int i = 0; i < numHilos; i++)
+    poolDestruir();
+    grafoLiberar(grafo);
+    free(entradas);
+    free(ops);
+    return estado;
+}
+
+// QUÉ: Detectar si se pidió el modo lote.
+// CÓMO: Busca -i, -o, --op o la ayuda entre los argumentos.
+// POR QUÉ: Sin esos argumentos se mantiene el menú interactivo de siempre.
+static int esModoLote(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
     {
-        pthread_join(hilos[i], NULL);
+        if (strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "-o") == 0 ||
+            strcmp(argv[i], "--op") == 0 || strcmp(argv[i], "-h") == 0 ||
+            strcmp(argv[i], "--help") == 0)
+            return 1;
     }
-    printf("Brillo ajustado concurrentemente con %d hilos (%s).\n", numHilos,
-           info->canales == 1 ? "grises" : "RGB");
+    return 0;
 }
 
 // QUÉ: Mostrar el menú interactivo.
@@ -311,15 +855,44 @@ void mostrarMenu()
 // POR QUÉ: Centraliza la lógica y asegura limpieza al salir.
 int main(int argc, char *argv[])
 {
-    ImagenInfo imagen = {0, 0, 0, NULL}; // Inicializar estructura
+    // QUÉ: Modo lote si hay -i/-o/--op.
+    // CÓMO: ejecutarLote procesa todo y devuelve el código de salida.
+    // POR QUÉ: Los scripts no necesitan simular pulsaciones del menú.
+    if (esModoLote(argc, argv))
+    {
+        return ejecutarLote(argc, argv);
+    }
+
+    ImagenInfo imagen = {0};             // Inicializar estructura
     char ruta[256] = {0};                // Buffer para ruta de archivo
 
+    // QUÉ: Leer la opción -j (número de hilos por defecto).
+    // CÓMO: -j N tiene prioridad sobre IMG_HILOS y las CPUs disponibles.
+    // POR QUÉ: Permite ajustar el paralelismo sin recompilar.
+    int argIndice = 1;
+    if (argc > 2 && strcmp(argv[1], "-j") == 0)
+    {
+        int n;
+        if (!poolLeerHilos(argv[2], &n))
+        {
+            fprintf(stderr, "Número de hilos inválido: %s\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+        poolFijarHilosPorDefecto(n);
+        argIndice = 3;
+    }
+
+    // QUÉ: Crear el pool de hilos una sola vez.
+    // CÓMO: Los hilos quedan dormidos hasta que una operación envía trabajo.
+    // POR QUÉ: Evita crear y unir hilos en cada operación.
+    poolIniciar(0);
+
     // QUÉ: Cargar imagen desde CLI si se pasa.
-    // CÓMO: Copia argv[1] y llama cargarImagen.
+    // CÓMO: Copia la ruta y llama cargarImagen.
     // POR QUÉ: Permite ejecución directa con ./img imagen.png.
-    if (argc > 1)
+    if (argc > argIndice)
     {
-        strncpy(ruta, argv[1], sizeof(ruta) - 1);
+        strncpy(ruta, argv[argIndice], sizeof(ruta) - 1);
         if (!cargarImagen(ruta, &imagen))
         {
             return EXIT_FAILURE;
@@ -390,7 +963,7 @@ int main(int argc, char *argv[])
             }
             while (getchar() != '\n')
                 ;
-            ajustarBrilloConcurrente(&imagen, delta);
+            ajustarBrilloConcurrente(&imagen, delta, 0);
             break;
         }
         case 5:
@@ -398,7 +971,7 @@ int main(int argc, char *argv[])
             int tamKernel, numHilos;
             float sigma;
 
-            printf("Tamaño del kernel (Debe ser impar)):");
+            printf("Tamaño del kernel (impar, 0 = automático): ");
             if (scanf("%d", &tamKernel) != 1)
             {
                 while (getchar() != '\n')
@@ -416,7 +989,7 @@ int main(int argc, char *argv[])
                 continue;
             }
 
-            printf("Número de hilos (1-4): ");
+            printf("Número de hilos (0 = automático): ");
             if (scanf("%d", &numHilos) != 1)
             {
                 while (getchar() != '\n')
@@ -448,14 +1021,14 @@ int main(int argc, char *argv[])
             }
             while (getchar() != '\n')
                 ;
-            rotarImagenConcurrente(&imagen, angulo);
+            rotarImagenConcurrente(&imagen, angulo, 0);
             break;
         }
 
         case 7:
         {
             int n;
-            printf("Número de hilos (>=1): ");
+            printf("Número de hilos (0 = automático): ");
             if (scanf("%d", &n) != 1)
             {
                 while (getchar() != '\n')
@@ -488,7 +1061,7 @@ int main(int argc, char *argv[])
                 printf("Entrada inválida.\n");
                 continue;
             }
-            printf("Número de hilos (1-4): ");
+            printf("Número de hilos (0 = automático): ");
             if (scanf("%d", &numHilos) != 1)
             {
                 while (getchar() != '\n')
@@ -507,6 +1080,7 @@ int main(int argc, char *argv[])
         }
         case 9: // Salir
             liberarImagen(&imagen);
+            poolDestruir();
             printf("¡Adiós!\n");
             return EXIT_SUCCESS;
         default: